@@ -0,0 +1,235 @@
+#ifndef __rgb_binaryio_h__
+#define __rgb_binaryio_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_binaryio.h
+##  This file defines the object needed to write and read binary RGB node
+##   files.
+##
+##  Binary node file layout (all values little-endian):
+##   offset  0 : char[8]  magic "RGBNODES"
+##   offset  8 : uint32   version
+##   offset 12 : uint32   header size
+##   offset 16 : uint64   number of nodes (N)
+##   offset 24 : uint64   name index offset  (N+1 uint32 string table offsets)
+##   offset 32 : uint64   string table offset
+##   offset 40 : uint64   string table size
+##   offset 48 : uint64   red column offset   (N float32)
+##   offset 56 : uint64   green column offset (N float32)
+##   offset 64 : uint64   blue column offset  (N float32)
+##   offset 72 : uint64   file size
+##   offset 80 : uint64   source file name offset
+##   offset 88 : uint64   source file name size
+##  Each color column starts on a CONST_BINARY_COLUMN_ALIGNMENT boundary.
+##
+##  The same file is used as a binary node config.  rgb_binary_view maps
+##   it read only; opening only checks the header, the nodes are read in
+##   place (see rgb_node_table).
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <stdint.h>
+
+// The fields of a binary node file header.
+class rgb_binary_header
+{
+public:
+    rgb_binary_header() { clear(); }
+    virtual ~rgb_binary_header() {}
+
+    void clear() {
+        num_nodes = name_index_offset = 0;
+        string_table_offset = string_table_size = 0;
+        red_offset = green_offset = blue_offset = 0;
+        file_size = source_offset = source_size = 0;
+    }
+
+    uint64_t num_nodes;
+    uint64_t name_index_offset;
+    uint64_t string_table_offset;
+    uint64_t string_table_size;
+    uint64_t red_offset;
+    uint64_t green_offset;
+    uint64_t blue_offset;
+    uint64_t file_size;
+    uint64_t source_offset;
+    uint64_t source_size;
+};
+
+class rgb_binaryio
+{
+public:
+    rgb_binaryio()
+    : STRING_error_layer("RGB_BINARYIO") {
+        aLogger = LoggerLevel::getInstance();
+    }
+
+    virtual ~rgb_binaryio() {
+        aLogger->releaseInstance();
+    }
+
+    // Takes in a rgb node vector and writes a binary node file.
+    void write_node_binary_file(vector<rgb_node> const &node_vector,
+            string const &source_file,
+            string const &output_file);
+
+    // Takes in the columns directly.
+    void write_node_binary_file(rgb_node_columns const &node_columns,
+            string const &source_file,
+            string const &output_file);
+
+    // Reads a binary node file into a rgb node vector.
+    void read_node_binary_file(string const &input_file,
+            vector<rgb_node> &node_vector);
+
+    // Reads a binary node file into columns.  The source file name
+    //  stored in the file is returned in source_file.
+    void read_node_binary_file(string const &input_file,
+            rgb_node_columns &node_columns,
+            string &source_file);
+
+    // Decodes a binary node file already held in memory.
+    void decode(const char *data, uint64_t size,
+            rgb_node_columns &node_columns,
+            string &source_file,
+            string const &input_file);
+
+    // Checks the header and that every section lies inside the buffer.
+    void read_header(const char *data, uint64_t size,
+            rgb_binary_header &header,
+            string const &input_file);
+
+    // Returns true if the buffer starts with the binary magic.
+    static bool is_binary(const char *data, uint64_t size);
+
+    // Returns true if the file starts with the binary magic.
+    static bool is_binary_file(string const &file_name);
+
+    // Little-endian encoding helpers.
+    static void put_u32(char *out, uint32_t value);
+    static void put_u64(char *out, uint64_t value);
+    static void put_f32(char *out, float value);
+    static uint32_t get_u32(const char *in);
+    static uint64_t get_u64(const char *in);
+    static float get_f32(const char *in);
+
+private:
+    void invalid(string const &input_file, string const &reason);
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+// A whole file mapped read only.  An empty file maps to no data.
+class rgb_mapped_file
+{
+public:
+    rgb_mapped_file()
+    : STRING_error_layer("RGB_MAPPED_FILE") {
+        aLogger = LoggerLevel::getInstance();
+        mapped_data = NULL;
+        mapped_size = 0;
+    }
+
+    virtual ~rgb_mapped_file() {
+        close();
+        aLogger->releaseInstance();
+    }
+
+    void open(string const &input_file);
+    void close();
+
+    const char *data() const { return mapped_data; }
+    uint64_t size() const { return mapped_size; }
+
+private:
+    rgb_mapped_file(const rgb_mapped_file&);
+    rgb_mapped_file& operator=(const rgb_mapped_file&);
+
+    const char *mapped_data;
+    uint64_t mapped_size;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+// A binary node file mapped into memory.  open() is O(1): only the header
+//  is checked.  Names and colors are decoded on access.
+class rgb_binary_view
+{
+public:
+    rgb_binary_view()
+    : STRING_error_layer("RGB_BINARY_VIEW") {
+        aLogger = LoggerLevel::getInstance();
+        data = NULL;
+        bytes = 0;
+    }
+
+    virtual ~rgb_binary_view() {
+        close();
+        aLogger->releaseInstance();
+    }
+
+    void open(string const &input_file);
+    void close();
+    bool is_open() const { return data != NULL; }
+
+    uint64_t size() const { return header.num_nodes; }
+    string name(uint64_t index) const;
+    float red(uint64_t index) const;
+    float green(uint64_t index) const;
+    float blue(uint64_t index) const;
+    string source() const;
+
+    // The mapped color columns, size() floats each, or NULL when the host
+    //  is not little-endian and the floats have to be decoded.
+    const float *red_column() const;
+    const float *green_column() const;
+    const float *blue_column() const;
+
+    // Copies every node out of the mapping.
+    void to_columns(rgb_node_columns &node_columns) const;
+    void to_nodes(vector<rgb_node> &node_vector) const;
+
+private:
+    rgb_binary_view(const rgb_binary_view&);
+    rgb_binary_view& operator=(const rgb_binary_view&);
+
+    void check_index(uint64_t index) const;
+
+    rgb_mapped_file mapping;
+    const char *data;
+    uint64_t bytes;
+    rgb_binary_header header;
+    string file_name;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
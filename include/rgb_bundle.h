@@ -0,0 +1,124 @@
+#ifndef __rgb_bundle_h__
+#define __rgb_bundle_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_bundle.h
+##  This file defines the object needed to write and read config bundles.
+##   A bundle holds the text configs of many source files in one file.
+##
+##  Bundle layout (all values little-endian):
+##   offset  0 : char[8]  magic "RGBBUNDL"
+##   offset  8 : uint32   version
+##   offset 12 : uint32   header size
+##   offset 16 : uint64   number of entries (N)
+##  followed by N index entries:
+##   uint64   config offset (from the start of the file)
+##   uint64   config length
+##   uint64   XXH64 hash of the config
+##   uint32   source path length
+##   char[]   source path
+##  followed by the configs.  Each config is a complete text config
+##   (V001 or V002) exactly as -extract would write it.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#ifndef __rgb_binaryio_h__
+#include "rgb_binaryio.h"
+#endif
+
+#include <map>
+#include <stdint.h>
+
+class rgb_bundle
+{
+public:
+    rgb_bundle()
+    : STRING_error_layer("RGB_BUNDLE") {
+        aLogger = LoggerLevel::getInstance();
+    }
+
+    virtual ~rgb_bundle() {
+        aLogger->releaseInstance();
+    }
+
+    // Maps a bundle and reads its index.  The configs are not read
+    //  until find() asks for them.
+    void open(string const &bundle_file);
+    void close();
+
+    // Number of configs in the bundle, counting the ones added.
+    size_t size() const;
+
+    // Looks up the config of a source file.  The path is matched first;
+    //  a bundle moved with its files still matches on the file name when
+    //  only one entry has it.  The config hash is checked before it is
+    //  returned.  Throws ENUM_NOT_IN_BUNDLE if there is no entry.  find()
+    //  does not change the bundle, so once it is open several threads
+    //  may call it.
+    void find(string const &source_file, const char *&data, uint64_t &length) const;
+
+    // Adds or replaces the config of a source file.  Nothing is written
+    //  until write().
+    void add(string const &source_file, string const &config_text);
+
+    // Writes every config, the ones read by open() included, through a
+    //  temp file that is renamed over bundle_file.
+    void write(string const &bundle_file);
+
+    // Returns true if the file starts with the bundle magic.
+    static bool is_bundle_file(string const &file_name);
+
+private:
+    rgb_bundle(const rgb_bundle&);
+    rgb_bundle& operator=(const rgb_bundle&);
+
+    class rgb_bundle_entry
+    {
+    public:
+        rgb_bundle_entry() : offset(0), length(0), hash(0) {}
+
+        uint64_t offset;
+        uint64_t length;
+        uint64_t hash;
+    };
+
+    void read_index();
+    void invalid(string const &reason) const;
+
+    rgb_mapped_file mapping;
+    string file_name;
+    map<string, rgb_bundle_entry> entries; // source path -> config in the mapping
+    map<string, string> file_names;        // file name -> source path, empty if shared
+    map<string, string> added;             // source path -> config text
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
@@ -0,0 +1,122 @@
+#ifndef __rgb_cache_h__
+#define __rgb_cache_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_cache.h
+##  This file defines the persistent cache of extracted RGB nodes.  Entries
+##   are keyed by the XXH64 content hash and the size of the VRML file so an
+##   unchanged file never has to be parsed again.
+##
+##  Cache file layout (all values little-endian):
+##   char[8] magic "RGBCACHE", uint32 version, uint32 reserved,
+##   uint64 use clock, uint64 number of entries, then per entry:
+##   uint64 hash, uint64 size, uint64 last use, uint32 number of nodes and
+##   per node uint32 name length, name, float32 red, green, blue.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+
+const string CONST_STRING_CACHE_MAGIC = "RGBCACHE"; // First 8 bytes of a cache file
+const unsigned int CONST_CACHE_CURRENT_VERSION = 1;
+const unsigned long CONST_CACHE_DEFAULT_SIZE_MB = 64; // Default cache size limit
+
+class rgb_cache
+{
+public:
+    rgb_cache()
+    : STRING_error_layer("RGB_CACHE") {
+        aLogger = LoggerLevel::getInstance();
+        size_limit = CONST_CACHE_DEFAULT_SIZE_MB * 1024 * 1024;
+        clear();
+    }
+
+    virtual ~rgb_cache() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        cache_file.clear();
+        entries.clear();
+        use_clock = 0;
+        total_bytes = 0;
+        dirty = false;
+        hits = misses = stores = evictions = 0;
+    }
+
+    // Loads the cache file.  A missing or unreadable cache file starts an
+    //  empty cache; it is only a cache.
+    void open(string const &file_name);
+
+    // Evicts down to the size limit and writes the cache file if anything
+    //  changed.
+    void save();
+
+    // Limit on the bytes of node data the cache keeps.  The least
+    //  recently used entries are evicted first.
+    void set_size_limit(uint64_t bytes) { size_limit = bytes; }
+
+    // lookup() and store() may be called from several threads.
+    bool lookup(uint64_t hash, uint64_t size, rgb_node_columns &nodes);
+    void store(uint64_t hash, uint64_t size, rgb_node_columns const &nodes);
+
+    // Prints "Cache : <hits> hits, <misses> misses, ..."
+    void print_statistics(ostream &out) const;
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long stores;
+    unsigned long evictions;
+
+private:
+    typedef pair<uint64_t, uint64_t> cache_key; // (hash, size)
+
+    struct cache_entry {
+        uint64_t last_use;
+        uint64_t bytes;
+        rgb_node_columns nodes;
+    };
+
+    static uint64_t entry_bytes(rgb_node_columns const &nodes);
+    void evict();
+
+    string cache_file;
+    map<cache_key, cache_entry> entries;
+    uint64_t use_clock;
+    uint64_t total_bytes;
+    uint64_t size_limit;
+    bool dirty;
+    mutex entries_mutex;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
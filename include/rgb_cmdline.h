@@ -45,7 +45,41 @@
 #include "rgb_rollback.h"
 #endif
 
+#ifndef __rgb_diff_h__
+#include "rgb_diff.h"
+#endif
+
+#ifndef __rgb_reduce_h__
+#include "rgb_reduce.h"
+#endif
+
+#ifndef __rgb_plan_h__
+#include "rgb_plan.h"
+#endif
+
+#ifndef __rgb_fanout_h__
+#include "rgb_fanout.h"
+#endif
+
+#ifndef __rgb_walk_h__
+#include "rgb_walk.h"
+#endif
+
+#ifndef __rgb_schedule_h__
+#include "rgb_schedule.h"
+#endif
+
+#ifndef __rgb_file_list_h__
+#include "rgb_file_list.h"
+#endif
+
+#ifndef __rgb_manifest_h__
+#include "rgb_manifest.h"
+#endif
+
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <functional>
 using namespace boost::filesystem;
 
 #if 0
@@ -113,6 +147,42 @@ public:
         temp.immediate_delete = false;
         available_commands.push_back(temp);
 
+        // -export command
+        temp._match = rgb_command_export::match1;
+        temp._factory = rgb_command_export::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -x (export) command
+        temp._match = rgb_command_export::match2;
+        temp._factory = rgb_command_export::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -to-binary command
+        temp._match = rgb_command_to_binary::match1;
+        temp._factory = rgb_command_to_binary::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -tb (to-binary) command
+        temp._match = rgb_command_to_binary::match2;
+        temp._factory = rgb_command_to_binary::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -to-text command
+        temp._match = rgb_command_to_text::match1;
+        temp._factory = rgb_command_to_text::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -tt (to-text) command
+        temp._match = rgb_command_to_text::match2;
+        temp._factory = rgb_command_to_text::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
         // -verify command
         temp._match = rgb_command_verify::match1;
         temp._factory = rgb_command_verify::factory;
@@ -125,6 +195,18 @@ public:
         temp.immediate_delete = false;
         available_commands.push_back(temp);
 
+        // -diff command
+        temp._match = rgb_command_diff::match1;
+        temp._factory = rgb_command_diff::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -d (diff) command
+        temp._match = rgb_command_diff::match2;
+        temp._factory = rgb_command_diff::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
         // -replace command
         temp._match = rgb_command_replace::match1;
         temp._factory = rgb_command_replace::factory;
@@ -137,6 +219,42 @@ public:
         temp.immediate_delete = false;
         available_commands.push_back(temp);
 
+        // -transform command
+        temp._match = rgb_command_transform::match1;
+        temp._factory = rgb_command_transform::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -t (transform) command
+        temp._match = rgb_command_transform::match2;
+        temp._factory = rgb_command_transform::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -remap command
+        temp._match = rgb_command_remap::match1;
+        temp._factory = rgb_command_remap::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -m (remap) command
+        temp._match = rgb_command_remap::match2;
+        temp._factory = rgb_command_remap::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -reduce command
+        temp._match = rgb_command_reduce::match1;
+        temp._factory = rgb_command_reduce::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
+        // -fanout command
+        temp._match = rgb_command_fanout::match1;
+        temp._factory = rgb_command_fanout::factory;
+        temp.immediate_delete = false;
+        available_commands.push_back(temp);
+
         // -rollback command
         temp._match = rgb_command_rollback::match1;
         temp._factory = rgb_command_rollback::factory;
@@ -180,6 +298,17 @@ public:
         : STRING_error_layer(rgb_base_name) {
             aLogger = LoggerLevel::getInstance();
             input_file_pairs.clear();
+            cache_size_mb = CONST_CACHE_DEFAULT_SIZE_MB;
+            config_timestamp = true;
+            config_palette = false;
+            dry_run = false;
+            jobs = 1;
+            recursive = false;
+            accepts_file_list = false;
+            files_processed = 0;
+            schedule = NULL;
+            skipped_extension = 0;
+            skipped_header = 0;
         }
 
         virtual ~rgb_command() {
@@ -196,17 +325,130 @@ public:
         void two_required(vector<string> &aCmdParam, string &p1, string &p2);
 
         void first_path_must_exist(string const &p1, vector<path> &path_listing);
+        bool vrml_file_wanted(path const &aPath);
+        bool vrml_extension_wanted(string const &aName);
+        bool vrml_header_wanted(path const &aPath);
+
+        // The name printed on the result line of a file.  The file name,
+        //  but the path below the root for a walked file and the path as
+        //  listed for a file from -files-from, so files of the same name in
+        //  different directories can be told apart.
+        string display_name(rgb_param_pair const &aPair) const;
+
         void first_path_must_exist_second_may_not_exist(string const &p1, string const &p2="");
+        void first_file_must_exist_second_may_not_exist(string const &p1, string const &p2="");
         void both_paths_must_exist(string const &p1, string const &p2);
 
+        // Command options follow the command parameters.  option() is called
+        //  with the next command line argument and returns true if it was 
+        //  consumed.  optional_switches() keeps calling it until it isn't.
+        void optional_switches(vector<string> &aCmdParam);
+        bool optional_switch(vector<string> &aCmdParam, string const &aSwitch);
+        bool optional_switch_value(vector<string> &aCmdParam, string const &aSwitch,
+            string &aValue);
+        virtual bool option(vector<string> &) { return false; }
+
+        // "-cache <file>" and "-cache-size <MB>" options for the commands
+        //  that extract nodes.  cache_close() saves the cache and prints the
+        //  hit and miss counts.
+        bool cache_option(vector<string> &aCmdParam);
+
+        // "-no-timestamp" leaves the "created" line out of written configs
+        //  and "-palette" writes them in the palette layout.
+        bool timestamp_option(vector<string> &aCmdParam);
+        bool palette_option(vector<string> &aCmdParam);
+
+        // "-remap <palette_config>" loads remap from STRING_remap_file.
+        bool remap_option(vector<string> &aCmdParam);
+
+        // "-dry-run" lists the colors a replace would change instead of
+        //  writing the file.  print_plan() prints them.
+        bool dry_run_option(vector<string> &aCmdParam);
+        void print_plan(ostream &out, vector<rgb_patch> const &plan);
+
+        // "-jobs <n>" processes n files at a time (0: one per core).
+        bool jobs_option(vector<string> &aCmdParam);
+
+        // "-recursive" walks the whole tree below a directory parameter.
+        //  "-max-depth <n>" and "-links <skip|files|follow>" set how far.
+        bool recursive_option(vector<string> &aCmdParam);
+
+        // True when for_each_pair() finds its files while it runs: by a
+        //  walk or from a file list.
+        bool streamed() const {
+            return !(STRING_walk_root.empty() && STRING_file_list.empty());
+        }
+
+        // Calls work(pair, out, worker) for every input pair, on up to
+        //  jobs threads.  worker is below worker_count(), so each worker
+        //  can keep its own engine.  What a file writes to out is printed
+        //  in input order once the files before it are done, so the
+        //  console shows the same as a serial run.  With -recursive or
+        //  -files-from the files are handed out while the tree is still
+        //  being walked or the list read, and are printed in the order
+        //  they were found.  The largest files are started first (see
+        //  rgb_schedule).
+        typedef std::function<void(rgb_param_pair const &, ostream &, unsigned int)> file_work;
+        void for_each_pair(file_work const &work);
+        unsigned int requested_workers() const;
+        unsigned int worker_count() const;
+
+        // Workers with no file to work on: idle in the schedule or not
+        //  started because there are fewer files than jobs.  work() may
+        //  use this many threads for one large file.
+        unsigned int spare_workers() const;
+
+        // "-tolerance <value>" sets comparator.  Accepts an absolute
+        //  tolerance ("1e-6") or a ULP count ("4ulp").
+        bool tolerance_option(vector<string> &aCmdParam);
+        void cache_open(rgb_cache &aCache, rgb_extract &anExtractObj);
+        void cache_close(rgb_cache &aCache);
+
         virtual void init(vector<string> &aCmdParam) =0;
         virtual void process() =0;
+
+        // Called after process().  Prints the end of run summary.
+        virtual void report();
         static rgb_command *factory() { return NULL; }
 
         string STRING_command_text;
         string STRING_param_one;
         string STRING_param_two;
 
+        string STRING_cache_file;
+        unsigned long cache_size_mb;
+        bool config_timestamp;
+        bool config_palette;
+        bool dry_run;
+        unsigned int jobs;
+        unsigned long files_processed; // by the last for_each_pair()
+        rgb_compare comparator;
+        rgb_remap remap;
+        string STRING_remap_file;
+
+        // Directory entries rejected before they reached a parser.
+        atomic<unsigned long> skipped_extension;
+        atomic<unsigned long> skipped_header;
+
+        // With -recursive first_path_must_exist() leaves the files of a
+        //  directory parameter to for_each_pair(), which walks it and
+        //  pairs each file with STRING_walk_config.
+        bool recursive;
+        rgb_walk walker;
+        string STRING_walk_root;
+        string STRING_walk_config;
+
+        // "-files-from <list|->" takes the place of the first parameter of
+        //  the commands that set accepts_file_list.  for_each_pair() reads
+        //  the list and pairs each file with its own config or with
+        //  STRING_walk_config.
+        bool accepts_file_list;
+        rgb_file_list file_list;
+        string STRING_file_list;
+
+        // Set while for_each_pair() runs workers.
+        rgb_schedule *schedule;
+
         // Holds either a pair of paths or a path and a filename.
         vector<rgb_param_pair> input_file_pairs;
         vector<string> commands_handled;
@@ -317,6 +559,7 @@ public:
             commands_handled.clear();
             commands_handled.push_back("-extract");
             commands_handled.push_back("-e");
+            accepts_file_list = true;
         }
 
         virtual ~rgb_command_extract() {}
@@ -337,11 +580,141 @@ public:
 
         virtual void init(vector<string> &aCmdParam) {
             one_required_one_optional(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
             first_path_must_exist_second_may_not_exist(STRING_param_one,STRING_param_two);
+            if ((!STRING_bundle_file.empty()) && (!STRING_param_two.empty())) {
+                aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                    "\"" + STRING_param_two + "\" cannot be used with -bundle.",
+                    __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+            }
+        }
+
+        virtual bool option(vector<string> &aCmdParam) {
+            return timestamp_option(aCmdParam) || palette_option(aCmdParam) ||
+                cache_option(aCmdParam) || jobs_option(aCmdParam) ||
+                recursive_option(aCmdParam) ||
+                optional_switch_value(aCmdParam, "-bundle", STRING_bundle_file);
         }
 
         virtual void process();
         static rgb_command *factory() { return new rgb_command_extract; }
+
+    private:
+        // "-bundle <file>" puts every config into one bundle.
+        string STRING_bundle_file;
+    };
+
+    class rgb_command_export : public rgb_command
+    {
+    public:
+        rgb_command_export() 
+        : rgb_command("RGB_CMD_EXPORT") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-export");
+            commands_handled.push_back("-x");
+        }
+
+        virtual ~rgb_command_export() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-export") {
+                return true;
+            }
+            return false;
+        }
+
+        static bool match2(string aParam) {
+            if (aParam == "-x") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            one_required_one_optional(aCmdParam,STRING_param_one,STRING_param_two);
+            first_path_must_exist_second_may_not_exist(STRING_param_one,STRING_param_two);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_export; }
+    };
+
+    class rgb_command_to_binary : public rgb_command
+    {
+    public:
+        rgb_command_to_binary()
+        : rgb_command("RGB_CMD_TO_BINARY") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-to-binary");
+            commands_handled.push_back("-tb");
+        }
+
+        virtual ~rgb_command_to_binary() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-to-binary") {
+                return true;
+            }
+            return false;
+        }
+
+        static bool match2(string aParam) {
+            if (aParam == "-tb") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            one_required_one_optional(aCmdParam,STRING_param_one,STRING_param_two);
+            first_file_must_exist_second_may_not_exist(STRING_param_one,STRING_param_two);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_to_binary; }
+    };
+
+    class rgb_command_to_text : public rgb_command
+    {
+    public:
+        rgb_command_to_text()
+        : rgb_command("RGB_CMD_TO_TEXT") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-to-text");
+            commands_handled.push_back("-tt");
+        }
+
+        virtual ~rgb_command_to_text() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-to-text") {
+                return true;
+            }
+            return false;
+        }
+
+        static bool match2(string aParam) {
+            if (aParam == "-tt") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            one_required_one_optional(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
+            first_file_must_exist_second_may_not_exist(STRING_param_one,STRING_param_two);
+        }
+
+        virtual bool option(vector<string> &aCmdParam) {
+            return timestamp_option(aCmdParam) || palette_option(aCmdParam);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_to_text; }
     };
 
     class rgb_command_verify : public rgb_command
@@ -353,6 +726,8 @@ public:
             commands_handled.clear();
             commands_handled.push_back("-verify");
             commands_handled.push_back("-v");
+            accepts_file_list = true;
+            verify_mode = ENUM_VERIFY_FAST_FAIL;
         }
 
         virtual ~rgb_command_verify() {}
@@ -373,11 +748,84 @@ public:
 
         virtual void init(vector<string> &aCmdParam) {
             two_required(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
             both_paths_must_exist(STRING_param_one,STRING_param_two);
         }
 
+        virtual bool option(vector<string> &aCmdParam) {
+            if (optional_switch(aCmdParam, "-full")) {
+                // Report every mismatched node instead of stopping
+                //  at the first one.
+                verify_mode = ENUM_VERIFY_FULL;
+                return true;
+            }
+            return tolerance_option(aCmdParam) || cache_option(aCmdParam) ||
+                jobs_option(aCmdParam) || recursive_option(aCmdParam);
+        }
+
         virtual void process();
         static rgb_command *factory() { return new rgb_command_verify; }
+
+        enum RGB_VERIFY_MODE verify_mode;
+    };
+
+    class rgb_command_diff : public rgb_command
+    {
+    public:
+        rgb_command_diff()
+        : rgb_command("RGB_CMD_DIFF") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-diff");
+            commands_handled.push_back("-d");
+            diff_mode = ENUM_DIFF_ALIGN;
+            diff_format = ENUM_DIFF_TEXT;
+        }
+
+        virtual ~rgb_command_diff() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-diff") {
+                return true;
+            }
+            return false;
+        }
+
+        static bool match2(string aParam) {
+            if (aParam == "-d") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            two_required(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
+            both_paths_must_exist(STRING_param_one,STRING_param_two);
+        }
+
+        virtual bool option(vector<string> &aCmdParam) {
+            if (optional_switch(aCmdParam, "-by-name")) {
+                diff_mode = ENUM_DIFF_BY_NAME;
+                return true;
+            }
+            if (optional_switch(aCmdParam, "-by-position")) {
+                diff_mode = ENUM_DIFF_BY_POSITION;
+                return true;
+            }
+            if (optional_switch(aCmdParam, "-machine")) {
+                // Tab separated records instead of readable lines.
+                diff_format = ENUM_DIFF_MACHINE;
+                return true;
+            }
+            return tolerance_option(aCmdParam);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_diff; }
+
+        enum RGB_DIFF_MODE diff_mode;
+        enum RGB_DIFF_FORMAT diff_format;
     };
 
     class rgb_command_replace : public rgb_command
@@ -389,6 +837,9 @@ public:
             commands_handled.clear();
             commands_handled.push_back("-replace");
             commands_handled.push_back("-r");
+            accepts_file_list = true;
+            keyed = false;
+            use_plan = false;
         }
 
         virtual ~rgb_command_replace() {}
@@ -409,11 +860,313 @@ public:
 
         virtual void init(vector<string> &aCmdParam) {
             two_required(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
             both_paths_must_exist(STRING_param_one,STRING_param_two);
         }
 
+        virtual bool option(vector<string> &aCmdParam) {
+            string aValue;
+            if (optional_switch(aCmdParam, "-keyed")) {
+                // Match config nodes to file nodes by name.
+                keyed = true;
+                return true;
+            }
+            if (optional_switch(aCmdParam, "-plan")) {
+                // Compile each config once and patch matching files
+                //  without the state machines.
+                use_plan = true;
+                return true;
+            }
+            if (optional_switch_value(aCmdParam, "-transform", aValue)) {
+                // Transform the config colors before they are written.
+                transform.compile(aValue);
+                STRING_transform = aValue;
+                return true;
+            }
+            if (optional_switch_value(aCmdParam, "-incremental", STRING_manifest_file)) {
+                // Skip files not changed since they were last replaced.
+                return true;
+            }
+            return remap_option(aCmdParam) || dry_run_option(aCmdParam) ||
+                timestamp_option(aCmdParam) || jobs_option(aCmdParam) ||
+                recursive_option(aCmdParam);
+        }
+
         virtual void process();
         static rgb_command *factory() { return new rgb_command_replace; }
+
+    private:
+        void print_unmatched(ostream &out, string const &aLabel,
+            vector<string> const &names);
+
+        // Hash of the options besides the config that change what is
+        //  written.  Part of the config hash kept in the manifest.
+        uint64_t settings_hash();
+
+        bool keyed;
+        bool use_plan;
+        rgb_transform transform;
+        string STRING_transform;
+        string STRING_manifest_file;
+    };
+
+    class rgb_command_transform : public rgb_command
+    {
+    public:
+        rgb_command_transform()
+        : rgb_command("RGB_CMD_TRANSFORM") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-transform");
+            commands_handled.push_back("-t");
+        }
+
+        virtual ~rgb_command_transform() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-transform") {
+                return true;
+            }
+            return false;
+        }
+
+        static bool match2(string aParam) {
+            if (aParam == "-t") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            vector<path> file_paths;
+            two_required(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
+            transform.compile(STRING_param_two);
+            first_path_must_exist(STRING_param_one, file_paths);
+
+            rgb_param_pair temp;
+            for(vector<path>::const_iterator ii = file_paths.begin();
+                ii != file_paths.end(); ii++)
+            {
+                temp.set(*ii);
+                input_file_pairs.push_back(temp);
+            }
+        }
+
+        virtual bool option(vector<string> &aCmdParam) {
+            return remap_option(aCmdParam) || dry_run_option(aCmdParam) ||
+                timestamp_option(aCmdParam);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_transform; }
+
+    private:
+        rgb_transform transform;
+    };
+
+    class rgb_command_remap : public rgb_command
+    {
+    public:
+        rgb_command_remap()
+        : rgb_command("RGB_CMD_REMAP") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-remap");
+            commands_handled.push_back("-m");
+        }
+
+        virtual ~rgb_command_remap() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-remap") {
+                return true;
+            }
+            return false;
+        }
+
+        static bool match2(string aParam) {
+            if (aParam == "-m") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            two_required(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
+            both_paths_must_exist(STRING_param_one,STRING_param_two);
+            remap.load(STRING_param_two);
+        }
+
+        virtual bool option(vector<string> &aCmdParam) {
+            return dry_run_option(aCmdParam) || timestamp_option(aCmdParam);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_remap; }
+    };
+
+    class rgb_command_reduce : public rgb_command
+    {
+    public:
+        rgb_command_reduce()
+        : rgb_command("RGB_CMD_REDUCE") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-reduce");
+            palette_colors = CONST_REDUCE_DEFAULT_COLORS;
+        }
+
+        virtual ~rgb_command_reduce() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-reduce") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            vector<path> file_paths;
+            two_required(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
+            first_path_must_exist(STRING_param_one, file_paths);
+
+            path path2(STRING_param_two);
+            if (exists(path2) && is_directory(path2))
+            {
+                aLogger->throw_exception(ENUM_PARAM_TWO_IS_DIRECTORY,
+                    "Parameter two: \"" + STRING_param_two +
+                    "\" cannot be a directory.  Check the path or filename.",
+                    __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+            }
+
+            rgb_param_pair temp;
+            for(vector<path>::const_iterator ii = file_paths.begin();
+                ii != file_paths.end(); ii++)
+            {
+                temp.set(*ii);
+                input_file_pairs.push_back(temp);
+            }
+        }
+
+        virtual bool option(vector<string> &aCmdParam) {
+            string aValue;
+            if (optional_switch_value(aCmdParam, "-colors", aValue)) {
+                char *end = NULL;
+                palette_colors = strtoul(aValue.c_str(), &end, 10);
+                if ((*end != '\0') || (aValue[0] == '-') || (palette_colors == 0)) {
+                    aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                        "Invalid color count \"" + aValue + "\".  Expected a number above zero.",
+                        __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+                }
+                return true;
+            }
+            return timestamp_option(aCmdParam);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_reduce; }
+
+    private:
+        unsigned long palette_colors;
+    };
+
+    class rgb_command_fanout : public rgb_command
+    {
+    public:
+        rgb_command_fanout()
+        : rgb_command("RGB_CMD_FANOUT") {
+            STRING_command_text.clear();
+            commands_handled.clear();
+            commands_handled.push_back("-fanout");
+            keyed = false;
+        }
+
+        virtual ~rgb_command_fanout() {}
+
+        static bool match1(string aParam) {
+            if (aParam == "-fanout") {
+                return true;
+            }
+            return false;
+        }
+
+        virtual void init(vector<string> &aCmdParam) {
+            two_required(aCmdParam,STRING_param_one,STRING_param_two);
+            optional_switches(aCmdParam);
+
+            // One source file ...
+            path path1(STRING_param_one);
+            if (!exists(path1))
+            {
+                aLogger->throw_exception(ENUM_FILE_OR_DIRECTORY_NOT_FOUND,
+                    "Parameter one: \"" + STRING_param_one + "\" does not exist.  Check the path or filename.",
+                    __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+            }
+            if (!is_regular_file(path1))
+            {
+                aLogger->throw_exception(ENUM_UNKNOWN_FILE_TYPE,
+                    "Parameter one: \"" + STRING_param_one + "\" must be a single VRML file.",
+                    __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+            }
+
+            // ... and a config or a directory of them.
+            path path2(STRING_param_two);
+            if (!exists(path2))
+            {
+                aLogger->throw_exception(ENUM_PARAM_TWO_NOT_FOUND,
+                    "Parameter two: \"" + STRING_param_two +
+                    "\" does not exist.  Check the path or filename.",
+                    __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+            }
+
+            vector<path> config_paths;
+            if (is_directory(path2))
+            {
+                copy(directory_iterator(path2), directory_iterator(),
+                    back_inserter(config_paths));
+                config_paths.erase(remove_if(config_paths.begin(), config_paths.end(),
+                    [](path const &A) { return !is_regular_file(A); }), config_paths.end());
+                sort(config_paths.begin(), config_paths.end());
+            }
+            else
+            {
+                config_paths.push_back(path2);
+            }
+
+            if (config_paths.empty())
+            {
+                aLogger->throw_exception(ENUM_NO_FILES_FOUND_IN_DIRECTORY,
+                    "No config files found in \"" + STRING_param_two + "\".  Nothing to do.",
+                    __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+            }
+
+            rgb_param_pair temp;
+            for (path ii : config_paths) {
+                temp.set(path1, ii.string());
+                input_file_pairs.push_back(temp);
+            }
+        }
+
+        virtual bool option(vector<string> &aCmdParam) {
+            if (optional_switch(aCmdParam, "-keyed")) {
+                keyed = true;
+                return true;
+            }
+            if (optional_switch_value(aCmdParam, "-out", STRING_output_directory)) {
+                return true;
+            }
+            return timestamp_option(aCmdParam);
+        }
+
+        virtual void process();
+        static rgb_command *factory() { return new rgb_command_fanout; }
+
+    private:
+        bool keyed;
+        string STRING_output_directory; // default: next to the source
     };
 
     class rgb_command_rollback : public rgb_command
@@ -425,6 +1178,7 @@ public:
             commands_handled.clear();
             commands_handled.push_back("-rollback");
             commands_handled.push_back("-roll");
+            accepts_file_list = true;
         }
 
         virtual ~rgb_command_rollback() {}
@@ -446,6 +1200,7 @@ public:
         virtual void init(vector<string> &aCmdParam) {
             vector<path> file_paths;
             one_required(aCmdParam,STRING_param_one);
+            optional_switches(aCmdParam);
             first_path_must_exist(STRING_param_one, file_paths);
 
             // Push all the elements in path_listing into the file pair vector
@@ -460,6 +1215,10 @@ public:
             }
         }
 
+        virtual bool option(vector<string> &aCmdParam) {
+            return jobs_option(aCmdParam) || recursive_option(aCmdParam);
+        }
+
         virtual void process();
         static rgb_command *factory() { return new rgb_command_rollback; }
     };
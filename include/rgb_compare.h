@@ -0,0 +1,108 @@
+#ifndef __rgb_compare_h__
+#define __rgb_compare_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_compare.h
+##  This file defines the object used to compare RGB color columns with an
+##   absolute and/or ULP tolerance.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+// Two colors are equal if they differ by no more than the absolute
+//  tolerance OR are no more than the ULP tolerance apart.  With both
+//  tolerances at zero this is the same as rgb_node::operator==.
+class rgb_compare
+{
+public:
+    rgb_compare()
+    : STRING_error_layer("RGB_COMPARE") {
+        aLogger = LoggerLevel::getInstance();
+        clear();
+    }
+
+    rgb_compare(rgb_compare const &other)
+    : absolute_tolerance(other.absolute_tolerance)
+    , ulp_tolerance(other.ulp_tolerance)
+    , STRING_error_layer(other.STRING_error_layer) {
+        aLogger = LoggerLevel::getInstance();
+    }
+
+    virtual ~rgb_compare() {
+        aLogger->releaseInstance();
+    }
+
+    rgb_compare& operator = (rgb_compare const &A) {
+        absolute_tolerance = A.absolute_tolerance;
+        ulp_tolerance = A.ulp_tolerance;
+        return *this;
+    }
+
+    void clear() {
+        absolute_tolerance = 0.0;
+        ulp_tolerance = 0;
+    }
+
+    void set_absolute_tolerance(float const &tolerance);
+    void set_ulp_tolerance(unsigned int const &tolerance);
+
+    float get_absolute_tolerance() const { return absolute_tolerance; }
+    unsigned int get_ulp_tolerance() const { return ulp_tolerance; }
+
+    // Clears result[ii] for every ii where a[ii] and b[ii] are not equal.
+    //  Elements already cleared stay cleared.
+    void compare_column(const float *a, const float *b, size_t count,
+            unsigned char *result) const;
+
+    // Compares count nodes of a (starting at a_offset) with b (starting at
+    //  b_offset).  The index of every mismatch, offset by a_offset, is
+    //  appended to mismatches.  Returns true if all of them matched.
+    bool compare(rgb_node_columns const &a, size_t a_offset,
+            rgb_node_columns const &b, size_t b_offset,
+            size_t count,
+            vector<unsigned int> &mismatches,
+            bool stop_at_first = false) const;
+
+    // Same with b given as three color columns, already at b_offset.
+    bool compare(rgb_node_columns const &a, size_t a_offset,
+            const float *b_red, const float *b_green, const float *b_blue,
+            size_t count,
+            vector<unsigned int> &mismatches,
+            bool stop_at_first = false) const;
+
+    bool equal(float const &a, float const &b) const;
+    bool equal(rgb_node const &a, rgb_node const &b) const;
+
+private:
+    float absolute_tolerance;
+    unsigned int ulp_tolerance;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
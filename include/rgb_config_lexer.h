@@ -0,0 +1,105 @@
+#ifndef __rgb_config_lexer_h__
+#define __rgb_config_lexer_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_config_lexer.h
+##  This file defines the tokenizer for RGB config text.  It works on a
+##   buffer already in memory, hands out tokens that point into the buffer
+##   and keeps the line and column of every token for error messages.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <cstring>
+
+// A word of the config.  Points into the lexer buffer.
+class rgb_config_token
+{
+public:
+    rgb_config_token() : text(NULL), size(0), line(0), column(0) {}
+    virtual ~rgb_config_token() {}
+
+    bool is(string const &aWord) const {
+        return (size == aWord.size()) && (memcmp(text, aWord.data(), size) == 0);
+    }
+
+    string str() const { return string(text, size); }
+
+    const char *text;
+    size_t size;
+    unsigned long line;
+    unsigned long column;
+};
+
+class rgb_config_lexer
+{
+public:
+    rgb_config_lexer()
+    : STRING_error_layer("RGB_CONFIG_LEXER") {
+        aLogger = LoggerLevel::getInstance();
+        open(NULL, 0, "");
+    }
+
+    virtual ~rgb_config_lexer() {
+        aLogger->releaseInstance();
+    }
+
+    // The buffer must stay valid while tokens are used.  aSourceName is
+    //  only used in error messages.
+    void open(const char *data, size_t size, string const &aSourceName);
+
+    // Next whitespace separated word.  Returns false at the end.
+    bool next(rgb_config_token &aToken);
+
+    // Skips the rest of the current line.
+    void skip_line();
+
+    // Conversions.  Both throw a parse error naming the token position.
+    unsigned long to_count(rgb_config_token const &aToken);
+    float to_color(rgb_config_token const &aToken);
+
+    // Throws a parse error at the token or at the end of the buffer.
+    void error(rgb_config_token const &aToken, string const &aMessage);
+    void error_at_end(string const &aMessage);
+
+    // Decimal to double.  Plain short decimals are converted directly;
+    //  anything else goes through strtod.  Returns false if the whole
+    //  text is not a number.
+    static bool parse_number(const char *text, size_t size, double &value);
+
+private:
+    const char *buffer_end;
+    const char *position;
+    const char *line_start;
+    unsigned long line_number;
+    string source_name;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
@@ -33,30 +33,78 @@
 #include "rgb_node.h"
 #endif
 
-class rgb_configio : public rgb_state_word
+#ifndef __rgb_config_lexer_h__
+#include "rgb_config_lexer.h"
+#endif
+
+#ifndef __rgb_node_index_h__
+#include "rgb_node_index.h"
+#endif
+
+#ifndef __rgb_binaryio_h__
+#include "rgb_binaryio.h"
+#endif
+
+#ifndef __rgb_bundle_h__
+#include "rgb_bundle.h"
+#endif
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+const size_t CONST_CONFIG_WRITE_BUFFER_SIZE = 64 * 1024; // ofstream buffer for configs
+
+class rgb_configio
 {
 public:
     rgb_configio()
-    : rgb_state_word((STATE)&rgb_configio::STATE_seek_START)
-    , STRING_error_layer("RGB_CONFIGIO") {
+    : STRING_error_layer("RGB_CONFIGIO") {
         aLogger = LoggerLevel::getInstance();
-        clear();
+        timestamp = true;
+        palette = false;
+        parse_palette = false;
     }
 
     virtual ~rgb_configio() {
         aLogger->releaseInstance();
     }
 
-    void clear() {
-        parse_temp_node.clear();
-        parse_config_vector.clear();
-        parse_config_number_of_nodes = 0;
-    }
-
     // Takes in a string containing the node config and returns a filled rgb node vector
-    //  from it.
+    //  from it.  A binary node file is recognized by its magic and its
+    //  nodes are copied out of the mapping.  rgb_config_cache reads it in
+    //  place instead.
     void parse_node_config(string const &aNodeConfig, vector<rgb_node> &node_vector);
 
+    // Parses config text already in memory.  aSourceName is used in the
+    //  error messages, which give the line and column of the problem.
+    void parse_node_config_buffer(const char *data, size_t size,
+            string const &aSourceName,
+            vector<rgb_node> &node_vector);
+
+    // Written configs carry a "#COMMENT created :" line unless this is
+    //  turned off.  The time is taken once per run.
+    void set_timestamp(bool aTimestamp) { timestamp = aTimestamp; }
+
+    // Write the palette (V002) config: each distinct color once and a
+    //  color number per node.
+    void set_palette(bool aPalette) { palette = aPalette; }
+
+    // True if the last config parsed was a palette config.
+    bool parsed_palette() const { return parse_palette; }
+
+    // Finds the distinct colors.  palette gets the position of the first
+    //  node with each color, node_colors the palette number of every node.
+    static void build_palette(vector<rgb_node> const &node_vector,
+            vector<unsigned int> &palette,
+            vector<unsigned int> &node_colors);
+
+    // Formats the node config straight into a stream.
+    void write_node_config(ostream &out,
+            vector<rgb_node> const &node_vector,
+            string const &source_file);
+
     // Takes in a full rgb node vector and returns a node config string.
     void create_node_config(vector<rgb_node> const &node_vector, 
             string const &source_file,
@@ -67,27 +115,119 @@ public:
             string const &source_file, 
             string const &output_file);
 
+    // Converts between the text config and the binary node file.  An
+    //  empty output name swaps the default file extentions.
+    void convert_to_binary(string const &config_file, string const &binary_file);
+    void convert_to_text(string const &binary_file, string const &config_file);
+
+    static string converted_file_name(string const &input_file,
+            string const &from_extention,
+            string const &to_extention);
+
 private:
-    bool read_word(string &aWord);
-
-    void STATE_seek_START(string const &aWord);
-    void STATE_seek_CONFIG_VERSION(string const &aWord);
-    void STATE_seek_NUM_NODES_KEYWORD(string const &aWord);
-    void STATE_read_NUM_NODES(string const &aWord);
-    void STATE_read_NODE_KEYWORD(string const &aWord);
-    void STATE_read_NODE_NAME(string const &aWord);
-    void STATE_read_RED(string const &aWord);
-    void STATE_read_GREEN(string const &aWord);
-    void STATE_read_BLUE(string const &aWord);
-    void STATE_NOOP(string);
-
-    rgb_node parse_temp_node;
-    vector<rgb_node> parse_config_vector;
-    unsigned int parse_config_number_of_nodes;
+    bool timestamp;
+    bool palette;
+    bool parse_palette;
 
     string STRING_error_layer;
     LoggerLevel *aLogger;
 };
 
+// A parsed config.  Built once and then only read, so it can be shared
+//  by every file (and worker) that uses the same config.
+//
+// A text config is held in columns.  A binary node file stays mapped and
+//  is read in place: opening it only checks the header, the colors are
+//  the mapped columns and a name is read from the string table when it
+//  is asked for.  The name index is built by the first find().
+class rgb_node_table
+{
+public:
+    rgb_node_table(vector<rgb_node> const &node_vector, bool aPalette = false);
+
+    // Maps binary_file (see rgb_binary_view).
+    explicit rgb_node_table(string const &binary_file);
+
+    virtual ~rgb_node_table() {}
+
+    size_t size() const { return count; }
+    string name(size_t index) const;
+    float red(size_t index) const { return reds[index]; }
+    float green(size_t index) const { return greens[index]; }
+    float blue(size_t index) const { return blues[index]; }
+    rgb_node node(size_t index) const;
+
+    // The color columns, size() floats each.
+    const float *red_column() const { return reds; }
+    const float *green_column() const { return greens; }
+    const float *blue_column() const { return blues; }
+
+    // Position of the first node called aName or CONST_NODE_INDEX_NOT_FOUND.
+    //  May be called from several threads.
+    long find(string const &aName) const;
+
+    const bool palette;   // parsed from a palette config
+
+private:
+    rgb_node_table(const rgb_node_table&);
+    rgb_node_table& operator=(const rgb_node_table&);
+
+    void build_index() const;
+
+    size_t count;
+    rgb_node_columns columns; // a text config; the colors of a binary file
+                              //  that is not in host byte order
+    rgb_binary_view view;     // a binary node file
+    const float *reds;
+    const float *greens;
+    const float *blues;
+
+    mutable once_flag index_built;
+    mutable rgb_node_index index; // node name -> position
+};
+
+typedef shared_ptr<const rgb_node_table> rgb_node_table_ptr;
+
+// Parses each distinct config once and hands out the shared table.
+//  get() may be called from several threads.  A config is loaded outside
+//  the lock by the first thread that asks for it; the others asking for
+//  the same config wait for that one, not for the whole cache.  A config
+//  that fails to load is not loaded again; later get() calls throw the
+//  same error.
+class rgb_config_cache
+{
+public:
+    rgb_config_cache() {}
+    virtual ~rgb_config_cache() {}
+
+    rgb_node_table_ptr get(string const &aNodeConfig);
+
+    // Same as above, but when aNodeConfig is a bundle the config of
+    //  aSourceFile is taken from it.  Each bundle is opened once.  A
+    //  bundle entry belongs to one file, so its table is not kept; it
+    //  goes away when the caller drops it.
+    rgb_node_table_ptr get(string const &aNodeConfig, string const &aSourceFile);
+
+    // True if aNodeConfig was opened as a bundle by get().
+    bool is_bundle(string const &aNodeConfig);
+
+    size_t size() {
+        lock_guard<mutex> lock(table_mutex);
+        return tables.size();
+    }
+
+private:
+    rgb_config_cache(const rgb_config_cache&);
+    rgb_config_cache& operator=(const rgb_config_cache&);
+
+    // Maps a binary node file or parses a text config.
+    static rgb_node_table_ptr load(string const &aNodeConfig);
+
+    map<string, shared_future<rgb_node_table_ptr> > tables;
+    map<string, shared_ptr<rgb_bundle> > bundles; // NULL if not a bundle
+    map<string, ErrException> bundle_failures;
+    mutex table_mutex;
+};
+
 #endif
 
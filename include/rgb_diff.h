@@ -0,0 +1,200 @@
+#ifndef __rgb_diff_h__
+#define __rgb_diff_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_diff.h
+##  This file defines the object needed to show the differences between
+##   the RGB nodes of a VRML file and a config, or of two VRML files.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#ifndef __rgb_extract_h__
+#include "rgb_extract.h"
+#endif
+
+#ifndef __rgb_compare_h__
+#include "rgb_compare.h"
+#endif
+
+#ifndef __rgb_configio_h__
+#include "rgb_configio.h"
+#endif
+
+#include <stdint.h>
+#include <deque>
+#include <unordered_map>
+
+// Largest edit distance the name alignment will search for.  The search
+//  keeps O(D*D) state, so past this the rest of the nodes are matched
+//  by name instead.
+const long CONST_DIFF_MAX_EDIT_DISTANCE = 2048;
+
+// Nodes read ahead on each side when two VRML files are diffed.  A node
+//  added or removed further away than this from its match is reported
+//  as removed on one side and added on the other.
+const size_t CONST_DIFF_WINDOW_SIZE = 4096;
+
+// How file nodes are paired with config nodes.
+enum RGB_DIFF_MODE {
+     ENUM_DIFF_ALIGN=0       // Shortest edit script over the node names
+    ,ENUM_DIFF_BY_NAME       // Same DEF name, wherever it is
+    ,ENUM_DIFF_BY_POSITION   // Same index
+};
+
+enum RGB_DIFF_FORMAT {
+     ENUM_DIFF_TEXT=0        // One readable line per difference
+    ,ENUM_DIFF_MACHINE       // One tab separated record per difference
+};
+
+enum RGB_DIFF_KIND {
+     ENUM_DIFF_CHANGED=0     // Paired, but the colors differ
+    ,ENUM_DIFF_ADDED         // Only in the file
+    ,ENUM_DIFF_REMOVED       // Only in the config
+};
+
+// Nodes read ahead from one of the two streamed files.  Node positions
+//  are counted from the start of the file.
+class rgb_diff_window
+{
+public:
+    rgb_diff_window() { clear(); }
+    virtual ~rgb_diff_window() {}
+
+    void clear() {
+        nodes.clear();
+        positions.clear();
+        first = 0;
+        done = false;
+    }
+
+    size_t size() const { return nodes.size(); }
+    bool empty() const { return nodes.empty(); }
+    rgb_node const &front() const { return nodes.front(); }
+
+    void push(rgb_node const &aNode);
+    void pop();
+
+    // Distance from front() to the first node called aName, or -1.
+    long find(string const &aName) const;
+
+    size_t first; // position of front() in the file
+    bool done;    // the file has no more nodes
+
+private:
+    deque<rgb_node> nodes;
+    unordered_map<string, deque<size_t> > positions; // name -> positions
+};
+
+class rgb_diff
+{
+public:
+    rgb_diff()
+    : STRING_error_layer("RGB_DIFF") {
+        aLogger = LoggerLevel::getInstance();
+        mode = ENUM_DIFF_ALIGN;
+        format = ENUM_DIFF_TEXT;
+        clear();
+    }
+
+    virtual ~rgb_diff() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        matched = changed = added = removed = 0;
+        file_offset = 0;
+    }
+
+    void set_mode(enum RGB_DIFF_MODE aMode) { mode = aMode; }
+    void set_format(enum RGB_DIFF_FORMAT aFormat) { format = aFormat; }
+    void set_compare(rgb_compare const &aCompare) { comparator = aCompare; }
+
+    // Streams the nodes of file_name against the config and writes one
+    //  line to out for each difference.  Returns true if there were none.
+    bool diff(string const &file_name, rgb_node_table const &config_table,
+            ostream &out);
+
+    // Streams two VRML files side by side.  old_file plays the part of
+    //  the config.  At most CONST_DIFF_WINDOW_SIZE nodes of each file are
+    //  held, so any size of file can be diffed.  ENUM_DIFF_BY_POSITION
+    //  pairs nodes by index, the other modes align them by name within
+    //  the window.
+    bool diff_files(string const &new_file, string const &old_file,
+            ostream &out);
+
+    // Counts for the last diff() or diff_files().
+    unsigned long matched;
+    unsigned long changed;
+    unsigned long added;
+    unsigned long removed;
+
+private:
+    void diff_by_position(rgb_node_table const &config_table, ostream &out);
+    void diff_by_name(rgb_node_table const &config_table, ostream &out);
+    void diff_aligned(rgb_node_table const &config_table, ostream &out);
+
+    void stream_by_position(ostream &out);
+    void stream_merge(ostream &out);
+    void fill(rgb_extract &anExtractor, rgb_diff_window &aWindow);
+
+    // Pairs file_nodes[file_begin, file_end) with the config nodes
+    //  [config_begin, config_end) by name and reports the result.
+    void align(rgb_node_table const &config_nodes,
+            size_t config_begin, size_t config_end,
+            size_t file_begin, size_t file_end,
+            ostream &out);
+    void match_names(rgb_node_table const &config_nodes,
+            size_t config_begin, size_t config_end,
+            size_t file_begin, size_t file_end,
+            ostream &out);
+
+    // Reports a file node paired with a config node.  Either may be NULL.
+    void compare_nodes(long file_index, rgb_node const *file_node,
+            long config_index, rgb_node const *config_node,
+            ostream &out);
+    void report(enum RGB_DIFF_KIND kind,
+            long file_index, rgb_node const *file_node,
+            long config_index, rgb_node const *config_node,
+            ostream &out);
+
+    enum RGB_DIFF_MODE mode;
+    enum RGB_DIFF_FORMAT format;
+    rgb_compare comparator;
+    rgb_extract extractor;
+    rgb_extract old_extractor; // second stream of diff_files()
+
+    string file_name;
+    vector<rgb_node> file_nodes; // file nodes held for alignment
+    size_t file_offset;          // file index of file_nodes[0]
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
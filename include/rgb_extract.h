@@ -32,6 +32,32 @@
 #include "rgb_node.h"
 #endif
 
+#ifndef __rgb_fileio_h__
+#include "rgb_fileio.h"
+#endif
+
+#ifndef __rgb_compare_h__
+#include "rgb_compare.h"
+#endif
+
+#ifndef __rgb_cache_h__
+#include "rgb_cache.h"
+#endif
+
+#ifndef __rgb_configio_h__
+#include "rgb_configio.h"
+#endif
+
+// Number of streamed nodes verify() buffers before comparing them
+//  with the config nodes.
+const unsigned int CONST_VERIFY_BLOCK_SIZE = 64;
+
+// How much work verify() does once a difference is found.
+enum RGB_VERIFY_MODE {
+     ENUM_VERIFY_FAST_FAIL=0 // Stop at the first mismatched node
+    ,ENUM_VERIFY_FULL        // Walk the whole file and report every mismatch
+};
+
 class rgb_extract : public rgb_state_word
 {
 public:
@@ -39,10 +65,15 @@ public:
     : rgb_state_word((STATE)&rgb_extract::STATE_verify_VRML)
     , STRING_error_layer("RGB_PARSE") {
         aLogger = LoggerLevel::getInstance();
+        srcFileIO = NULL;
+        node_cache = NULL;
+        config_timestamp = true;
+        config_palette = false;
         clear();
-    }; 
+    };
 
     virtual ~rgb_extract() {
+        if (srcFileIO) delete srcFileIO;
         aLogger->releaseInstance();
     }
 
@@ -51,14 +82,62 @@ public:
         last_word.clear();
         rgb_list.clear();
         temp_node.clear();
+        node_ready = false;
         TRAN((STATE)&rgb_extract::STATE_verify_VRML); // Set the initial state.
     }
 
     void extract(string const &file_name, string const &rgb_node_file_name="");
+    // Returns the config text instead of writing it to a file.
+    void extract_config(string const &file_name, string &aNodeConfig);
+    void extract_binary(string const &file_name, string const &rgb_binary_file_name="");
     void extract_nodes(string const &file, vector<rgb_node> &rgb_list);
+
+    // Streaming interface.  Opens the file and returns one RGB node per
+    //  call to next_node() until the file is exhausted.
+    void open_stream(string const &file_name);
+    bool next_node(rgb_node &aNode);
+    void close_stream();
+
+    // Compares the nodes in the file with the ones in the config file while
+    //  the file is being parsed.  The indices of mismatched nodes are returned
+    //  in mismatches.  ENUM_VERIFY_FAST_FAIL stops at the first one.
+    //  Colors are compared with the tolerance set by set_compare().
     bool verify(string const &file_name, string const &rgb_node_file_name);
+    bool verify(string const &file_name, string const &rgb_node_file_name,
+            vector<unsigned int> &mismatches,
+            enum RGB_VERIFY_MODE mode = ENUM_VERIFY_FAST_FAIL);
+
+    // Same as above with a config that has already been parsed.
+    bool verify(string const &file_name, rgb_node_table const &config_table,
+            vector<unsigned int> &mismatches,
+            enum RGB_VERIFY_MODE mode = ENUM_VERIFY_FAST_FAIL);
+
+    void set_compare(rgb_compare const &aCompare) {
+        comparator = aCompare;
+    }
+
+    // When a cache is set extract_nodes() looks the file up by content
+    //  hash before parsing it.  The cache is not owned by rgb_extract.
+    void set_cache(rgb_cache *aCache) {
+        node_cache = aCache;
+    }
+
+    // Passed on to the config writer.
+    void set_timestamp(bool aTimestamp) {
+        config_timestamp = aTimestamp;
+    }
+
+    void set_palette(bool aPalette) {
+        config_palette = aPalette;
+    }
 
 private:
+    void parse_nodes(string const &file, vector<rgb_node> &rgb_list);
+    void compare_block(rgb_node_columns const &block, unsigned int index,
+            rgb_node_table const &config_table,
+            vector<unsigned int> &mismatches,
+            enum RGB_VERIFY_MODE mode);
+
     // Verify its a VRML file
     void STATE_verify_VRML(const string &aWord);
     void STATE_verify_VRML_VER(const string &aWord);
@@ -74,6 +153,13 @@ private:
     void STATE_get_BLUE(const string &aWord);
 
 
+    rgb_fileio *srcFileIO;
+    bool node_ready;
+    rgb_compare comparator;
+    rgb_cache *node_cache;
+    bool config_timestamp;
+    bool config_palette;
+
     string in_file_name;
     string last_word;
     string STRING_error_layer;
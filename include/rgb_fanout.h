@@ -0,0 +1,142 @@
+#ifndef __rgb_fanout_h__
+#define __rgb_fanout_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_fanout.h
+##  This file defines the object that writes many color variants of one
+##   VRML file.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#ifndef __rgb_configio_h__
+#include "rgb_configio.h"
+#endif
+
+#ifndef __rgb_plan_h__
+#include "rgb_plan.h"
+#endif
+
+// One output of a fan-out.
+struct rgb_variant {
+    string config_file;
+    string output_file;
+    rgb_node_table_ptr config_table;
+    unsigned int changed;   // colors that differ from the source
+    string error;           // empty when the output was written
+};
+
+// open() maps and scans the source once.  write() then writes every
+//  variant added: the source with each color taken from that variant's
+//  config, by position or (keyed) by name, the same as copying the source
+//  and running replace() on the copy.  The unchanged text between the
+//  colors is written straight from the one source mapping and the outputs
+//  are written by several threads at once.
+//
+// Every output carries the history config of the source, so -rollback on
+//  any of them gives back the source colors.
+class rgb_fanout
+{
+public:
+    rgb_fanout()
+    : STRING_error_layer("RGB_FANOUT") {
+        aLogger = LoggerLevel::getInstance();
+        threads = 0;
+        keyed = false;
+        config_timestamp = true;
+        clear();
+    }
+
+    virtual ~rgb_fanout() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        source_file.clear();
+        mapping.close();
+        spans.clear();
+        source_nodes.clear();
+        history[0].clear();
+        history[1].clear();
+        def_offset = 0;
+        scanned = false;
+        variants.clear();
+    }
+
+    // 0 uses one thread per core.
+    void set_threads(unsigned int aThreads) { threads = aThreads; }
+    void set_keyed(bool aKeyed) { keyed = aKeyed; }
+    void set_timestamp(bool aTimestamp) { config_timestamp = aTimestamp; }
+
+    void open(string const &rgb_file);
+    void add(rgb_node_table_ptr config_table, string const &rgb_config_file,
+            string const &output_file);
+
+    // Writes every variant.  Failures are kept in rgb_variant::error.
+    void write();
+
+    vector<rgb_variant> variants;
+
+private:
+    // Position in the config of the node for the color at position, or
+    //  CONST_NODE_INDEX_NOT_FOUND to keep it.
+    long target(rgb_variant const &aVariant, unsigned int position) const;
+
+    // Checks a variant and makes its history config.  Runs before the
+    //  threads start.
+    void prepare(rgb_variant &aVariant);
+
+    // A write error, turned into rgb_variant::error by the logger once
+    //  the threads are done.
+    struct write_failure {
+        bool failed;
+        enum EXCEPTION_STRING_ARRAY code;
+        string detail;
+    };
+
+    // Runs in a worker thread, so it does not use the logger.
+    void write_variant(rgb_variant const &aVariant, write_failure &aFailure) const;
+
+    unsigned int worker_count() const;
+
+    string source_file;
+    rgb_mapped_file mapping;         // the whole source file
+    size_t def_offset;
+    bool scanned;                    // false: each variant is a copy and a replace()
+    vector<rgb_plan::color_span> spans;
+    vector<rgb_node> source_nodes;
+    string history[2];               // text and palette layout
+    unsigned int threads;
+    bool keyed;
+    bool config_timestamp;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
@@ -0,0 +1,94 @@
+#ifndef __rgb_file_list_h__
+#define __rgb_file_list_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_file_list.h
+##  This file defines the object that reads a list of files to process
+##   from a file or standard input.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <fstream>
+#include <stdint.h>
+
+// One file per record.  Records end in a newline, or in a NUL when the
+//  first record does (as written by "find -print0"); the separator is
+//  not mixed within a list.  A record may name a config after a TAB:
+//
+//   models/chair.wrl
+//   models/table.wrl<TAB>configs/table_rgb_nodes.txt
+//
+// Empty records are skipped and a CR before a newline is dropped.  The
+//  list is read as it is asked for, so a list still being written to a
+//  pipe can be worked on before it ends.
+class rgb_file_list
+{
+public:
+    rgb_file_list()
+    : STRING_error_layer("RGB_FILE_LIST") {
+        aLogger = LoggerLevel::getInstance();
+        input = NULL;
+        clear();
+    }
+
+    virtual ~rgb_file_list() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        separator = -1;
+        records = 0;
+        missing = 0;
+    }
+
+    // "-" reads standard input.
+    void open(string const &file_name);
+
+    // The next regular file of the list and its size.  aConfig is empty
+    //  when the record does not name one.  Entries that are not regular
+    //  files are counted in missing and skipped.  False at the end.
+    bool next(string &aPath, string &aConfig, uint64_t &aSize);
+
+    // Counts of the list read so far.
+    unsigned long records;
+    unsigned long missing;   // not found or not a regular file
+
+private:
+    // One record without its separator.  False at the end of the list.
+    bool read_record(string &aRecord);
+
+    ifstream list_file;
+    istream *input;
+    int separator;           // -1 until the first record ends
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
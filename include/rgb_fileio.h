@@ -76,10 +76,15 @@ public:
     bool read_char(char &aChar);
     void write(string const &A);
     void write(char const &A);
+    void write(const char *A, size_t length);
     void overwrite();
     void close();
     void erase();
 
+    // Reads the first CONST_VRML_HEADER_SNIFF_SIZE bytes of a file and 
+    //  returns true if they hold the "#VRML V2.0 utf8" header.  Never throws.
+    static bool is_vrml_header(string const &file_name);
+
 private:
     string   source_file_name;
     ifstream source_file_stream;
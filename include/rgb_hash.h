@@ -0,0 +1,78 @@
+#ifndef __rgb_hash_h__
+#define __rgb_hash_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_hash.h
+##  This file defines a streaming 64 bit content hash (XXH64) used to
+##   recognize files that have not changed between runs.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <stdint.h>
+
+class rgb_hash
+{
+public:
+    rgb_hash(uint64_t seed = 0)
+    : STRING_error_layer("RGB_HASH") {
+        aLogger = LoggerLevel::getInstance();
+        clear(seed);
+    }
+
+    virtual ~rgb_hash() {
+        aLogger->releaseInstance();
+    }
+
+    void clear(uint64_t seed = 0);
+
+    // Add more bytes to the hash.
+    void update(const void *data, size_t length);
+
+    // Hash of everything added so far.  Does not change the state.
+    uint64_t digest() const;
+
+    uint64_t length() const { return total_length; }
+
+    // Hashes a whole buffer.
+    static uint64_t hash(const void *data, size_t length, uint64_t seed = 0);
+
+    // Hashes a file.  Also returns the number of bytes read.
+    void hash_file(string const &file_name, uint64_t &hash_value, uint64_t &file_size);
+
+private:
+    uint64_t seed;
+    uint64_t v1, v2, v3, v4;
+    uint64_t total_length;
+    unsigned char pending[32];
+    size_t pending_size;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef __rgb_manifest_h__
+#define __rgb_manifest_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_manifest.h
+##  This file defines the manifest of files already processed, used to
+##   skip unchanged files on the next run.
+##
+##  Manifest file layout (little-endian):
+##   "RGBMANIF", uint32 version, uint32 reserved, uint64 number of
+##   entries, then per entry: uint64 size, int64 mtime (ns), int64 start
+##   of the run that hashed it (ns), uint64 content hash, uint64 config
+##   hash, uint32 path length, path.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+
+const string CONST_STRING_MANIFEST_MAGIC = "RGBMANIF"; // First 8 bytes of a manifest file
+const unsigned int CONST_MANIFEST_CURRENT_VERSION = 1;
+
+// File times come from a coarser clock than the run start and some file
+//  systems keep whole seconds.  An mtime this close to the hash is not
+//  trusted.
+const int64_t CONST_MANIFEST_MTIME_SLACK_NS = 2000000000LL;
+
+// For each file: its size, mtime and XXH64 content hash when it was last
+//  processed, and the hash of the config and settings it was processed
+//  with.  A file is unchanged when its config hash is the same and either
+//  its size and mtime are (one stat()) or, if the mtime moved or is too
+//  recent to trust, its content hash is.
+//
+// An mtime is only trusted if it is older than the start of the run that
+//  hashed the file, less CONST_MANIFEST_MTIME_SLACK_NS.  A file changed
+//  during that run may have kept the same mtime; its content is hashed
+//  again instead.
+class rgb_manifest
+{
+public:
+    rgb_manifest()
+    : STRING_error_layer("RGB_MANIFEST") {
+        aLogger = LoggerLevel::getInstance();
+        clear();
+    }
+
+    virtual ~rgb_manifest() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        manifest_file.clear();
+        entries.clear();
+        run_started = 0;
+        dirty = false;
+        unchanged = hashed = recorded = 0;
+    }
+
+    // Loads the manifest file.  A missing or unreadable manifest starts
+    //  empty; every file is then processed and recorded.
+    void open(string const &file_name);
+
+    // Writes the manifest file if anything changed.
+    void save();
+
+    // is_unchanged() and record() may be called from several threads.
+    bool is_unchanged(string const &file_name, uint64_t config_hash);
+
+    // Records file_name as it is now.  A file that cannot be read is
+    //  left out.
+    void record(string const &file_name, uint64_t config_hash);
+
+    // Prints "Incremental : <unchanged> unchanged, ..."
+    void print_statistics(ostream &out) const;
+
+    unsigned long unchanged;  // skipped
+    unsigned long hashed;     // of those, the ones whose content was hashed
+    unsigned long recorded;
+
+private:
+    struct manifest_entry {
+        uint64_t size;
+        int64_t mtime;
+        int64_t checked;     // run_started of the run that hashed it
+        uint64_t content_hash;
+        uint64_t config_hash;
+    };
+
+    static int64_t now();
+
+    string manifest_file;
+    map<string, manifest_entry> entries;
+    int64_t run_started;
+    bool dirty;
+    mutex entries_mutex;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
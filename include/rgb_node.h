@@ -35,6 +35,7 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <atomic>
 
 using namespace std;
 
@@ -46,6 +47,7 @@ const float CONST_RGB_COLOR_VALUE_MAX = 1.0; // Maximum RGB color value
 // rgb_fileio defines
 const string CONST_STRING_DEFAULT_TEMP_FILE_EXTENTION = "_temp.txt"; // temp file string extention
 const string CONST_STRING_DEFAULT_RGB_NODE_FILE_EXTENTION = "_rgb_nodes.txt"; // standard RGB node file extention
+const string CONST_STRING_DEFAULT_RGB_BINARY_FILE_EXTENTION = "_rgb_nodes.bin"; // binary RGB node file extention
 const string CONST_STRING_DEFAULT_ARGUMENT_ZERO = "./RGB_color_parse"; // standard RGB node file extention
 
 // VRML file defines
@@ -55,15 +57,38 @@ const string CONST_STRING_VRML_CHARSET_KEYWORD = "utf8";
 const string CONST_STRING_DEF_KEYWORD = "DEF";
 const string CONST_STRING_TRANSFORM_KEYWORD = "Transform";
 const string CONST_STRING_DIFFUSECOLOR_KEYWORD = "diffuseColor";
+const string CONST_STRING_VRML_HEADER = CONST_STRING_VRML_KEYWORD + " " +
+    CONST_STRING_VRML_VER_KEYWORD + " " + CONST_STRING_VRML_CHARSET_KEYWORD;
+const unsigned int CONST_VRML_HEADER_SNIFF_SIZE = 16; // Bytes read to recognize a VRML file
+const string CONST_STRING_VRML_FILE_EXTENTION = ".wrl"; // Directory scans only take these
+const string CONST_STRING_VRML_ALT_FILE_EXTENTION = ".vrml";
 
 // CONFIG FILE DEFINES
 const string CONST_STRING_CONFIG_START_KEYWORD = "#START";
 const string CONST_STRING_CONFIG_CURRENT_VERSION = "V001";
+const string CONST_STRING_CONFIG_PALETTE_VERSION = "V002"; // #NODE lines name a palette color
 const string CONST_STRING_CONFIG_COMMENT_KEYWORD = "#COMMENT";
 const string CONST_STRING_CONFIG_NUM_NODES_KEYWORD = "#NUM_NODES";
 const string CONST_STRING_CONFIG_NODE_KEYWORD = "#NODE";
+const string CONST_STRING_CONFIG_NUM_COLORS_KEYWORD = "#NUM_COLORS";
+const string CONST_STRING_CONFIG_COLOR_KEYWORD = "#COLOR";
 const string CONST_STRING_CONFIG_END_KEYWORD = "#END";
 
+// BINARY FILE DEFINES
+//  All binary values are little-endian.  The RGB columns are float32 
+//  arrays aligned to CONST_BINARY_COLUMN_ALIGNMENT bytes.
+const string CONST_STRING_BINARY_MAGIC = "RGBNODES"; // First 8 bytes of a binary node file
+const unsigned int CONST_BINARY_CURRENT_VERSION = 1;
+const unsigned int CONST_BINARY_HEADER_SIZE = 96;
+const unsigned int CONST_BINARY_COLUMN_ALIGNMENT = 64;
+
+// BUNDLE FILE DEFINES
+//  A bundle holds the text configs of many source files behind an index.
+const string CONST_STRING_BUNDLE_MAGIC = "RGBBUNDL"; // First 8 bytes of a config bundle
+const unsigned int CONST_BUNDLE_CURRENT_VERSION = 1;
+const unsigned int CONST_BUNDLE_HEADER_SIZE = 24;
+const unsigned int CONST_BUNDLE_ENTRY_SIZE = 28; // Index entry without its source path
+
 // EXCEPTION STRINGS
 //  The enum values must match the strings defined
 //  in the exception_string_response
@@ -104,6 +129,10 @@ enum EXCEPTION_STRING_ARRAY {
     ,ENUM_UNABLE_TO_WRITE_CONFIG
     ,ENUM_PARSE_ERROR  // 27
     ,ENUM_NOTHING_TO_DO // 28
+    ,ENUM_INVALID_BINARY_FILE
+    ,ENUM_CONFIG_PARSE_ERROR // 30
+    ,ENUM_INVALID_BUNDLE_FILE
+    ,ENUM_NOT_IN_BUNDLE
 
     // Must be last ... used in exception_response string array
     ,ENUM_LAST_ELEMENT
@@ -139,6 +168,10 @@ const string exception_response[ENUM_LAST_ELEMENT][2] = {
 ,{"Unable to write config." ,"Unable to write config file." }
 ,{"Not a VRML file." ,"Parse error.  Not a VRML file." }  // 27
 ,{"No commands to execute.", "No commands were found on command line.  Nothing to do." } // 28
+,{"Invalid binary file.", "Binary node file is truncated or corrupt." }
+,{"Config parse error.", "Parse error.  Not a valid RGB config." } // 30
+,{"Invalid bundle file.", "Config bundle is truncated or corrupt." }
+,{"Not in bundle.", "Source file has no config in the bundle." }
 };
 
 
@@ -167,34 +200,35 @@ debug_method_name << endl << STRING_error_layer << ":ERROR_MSG: "
 class ErrException : public exception
 {
 public:
-   ErrException(string ss) : s(ss) {}
+   ErrException(string ss, enum EXCEPTION_STRING_ARRAY x = ENUM_LAST_ELEMENT)
+   : s(ss), code(x) {}
    virtual ~ErrException() throw() {}
    const char* what() const throw() { return s.c_str(); }
 
+   // The error thrown, ENUM_LAST_ELEMENT if it was only a message.
+   enum EXCEPTION_STRING_ARRAY error() const { return code; }
+
 private:
    string s;
+   enum EXCEPTION_STRING_ARRAY code;
 };
 
 // Singleton class to hold the logger level.
-//  This allows it to be set and read by everyone.
+//  This allows it to be set and read by everyone.  Any thread may get
+//  and release it: the instance is made on first use and kept for the
+//  whole run, and the reference count and level are atomic.
 class LoggerLevel { 
 public: 
     static LoggerLevel* getInstance() { 
-        if (NULL == _instance) { 
-            _instance = new LoggerLevel(); 
-        } 
+        static LoggerLevel anInstance;
         _referenceCount++; 
         DEBUG_LOGGER_REFGET
-        return _instance; 
+        return &anInstance; 
     }
  
     static void releaseInstance() { 
         _referenceCount--; 
         DEBUG_LOGGER_REFRELEASE
-        if ((0 == _referenceCount) && (NULL != _instance)) { 
-            delete _instance; 
-            _instance = NULL; 
-        } 
     }
 
     enum EXCEPTION_STRING_ARRAY_LEVEL getLevel() { return level; }
@@ -218,7 +252,7 @@ public:
         } else {
             anError << EXCEPTION_STRING_PREAMBLE << ss << endl;
         }
-        throw_exception(anError.str());
+        throw ErrException(anError.str(), x);
     }
 
     void throw_exception(
@@ -250,9 +284,8 @@ private:
         return *this; 
     }
  
-    static int _referenceCount; 
-    static LoggerLevel* _instance;
-    enum EXCEPTION_STRING_ARRAY_LEVEL level;
+    static atomic<int> _referenceCount; 
+    atomic<enum EXCEPTION_STRING_ARRAY_LEVEL> level;
 };
  
 
@@ -506,7 +539,7 @@ public:
     , green(other.green)
     , blue(other.blue) 
     , name(other.name) {
-        aLogger->getInstance();
+        aLogger = LoggerLevel::getInstance();
     }
 
 private:
@@ -540,5 +573,35 @@ private:
     LoggerLevel *aLogger;
 };
 
+// This class holds the same values as a vector of rgb_nodes but
+//  stored as columns.  The names are kept in one vector and each 
+//  color in its own contiguous float array.
+class rgb_node_columns
+{
+public:
+    rgb_node_columns() { clear(); }
+    virtual ~rgb_node_columns() {}
+
+    void clear() {
+        name.clear();
+        red.clear();
+        green.clear();
+        blue.clear();
+    }
+
+    size_t size() const {
+        return name.size();
+    }
+
+    // Converts between the node vector and the column layout.
+    void assign(vector<rgb_node> const &node_vector);
+    void to_nodes(vector<rgb_node> &node_vector) const;
+
+    vector<string> name;
+    vector<float> red;
+    vector<float> green;
+    vector<float> blue;
+};
+
 #endif
 
@@ -0,0 +1,80 @@
+#ifndef __rgb_node_index_h__
+#define __rgb_node_index_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_node_index.h
+##  This file defines an open addressing hash index from node name to the
+##   position of the node in a config.  Used by the keyed replace.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <stdint.h>
+
+const long CONST_NODE_INDEX_NOT_FOUND = -1;
+
+class rgb_node_index
+{
+public:
+    rgb_node_index() {
+        clear();
+    }
+
+    virtual ~rgb_node_index() {}
+
+    void clear() {
+        slots.clear();
+        names.clear();
+        mask = 0;
+    }
+
+    // Indexes the names of node_vector.  When a name is repeated the
+    //  first node wins.
+    void build(vector<rgb_node> const &node_vector);
+
+    // Same with the names alone, in node order.
+    void build(vector<string> const &node_names);
+
+    // Position of the node called aName or CONST_NODE_INDEX_NOT_FOUND.
+    long find(string const &aName) const;
+
+    size_t size() const { return names.size(); }
+
+private:
+    // A slot holds the name hash and the node position plus one.  Zero
+    //  marks an empty slot.
+    struct slot {
+        uint64_t hash;
+        uint32_t position;
+    };
+
+    vector<slot> slots;
+    vector<string> names;
+    uint64_t mask;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef __rgb_plan_h__
+#define __rgb_plan_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_plan.h
+##  This file defines a config compiled into a replacement plan that can
+##   be applied to many files with the same layout.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#ifndef __rgb_replace_h__
+#include "rgb_replace.h"
+#endif
+
+#ifndef __rgb_hash_h__
+#include "rgb_hash.h"
+#endif
+
+#ifndef __rgb_binaryio_h__
+#include "rgb_binaryio.h"
+#endif
+
+#include <stdint.h>
+
+// scan() splits files of at least two of these into chunks.
+const size_t CONST_PLAN_CHUNK_SIZE = 8 * 1024 * 1024;
+
+// A plan is the new color text for every diffuseColor of a file, by
+//  position, and a fingerprint of the layout it was made for: the number
+//  of colors and the hash of their node names in order.  Files made from
+//  the same template match the fingerprint however their geometry differs.
+//
+// apply() maps the file, finds the color values with a plain word scan
+//  and writes the file with the new values and the same history config a
+//  replace writes.  The text between the colors is written straight from
+//  the mapping.  The result is byte for byte what replace()
+//  gives.  A file that does not match is left alone so the caller can
+//  fall back to replace().
+class rgb_plan
+{
+public:
+    rgb_plan()
+    : STRING_error_layer("RGB_PLAN") {
+        aLogger = LoggerLevel::getInstance();
+        config_timestamp = true;
+        threads = 1;
+        clear();
+    }
+
+    virtual ~rgb_plan() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        config_file.clear();
+        names.clear();
+        targets.clear();
+        values.clear();
+        fingerprint = 0;
+        palette = false;
+        usable = false;
+        patches.clear();
+    }
+
+    // The config colors go through the transform and then the palette,
+    //  as in rgb_replace.  Either may be NULL.  A keyed plan is only
+    //  usable when every config name is unique.
+    void compile(rgb_node_table const &config_table, string const &rgb_config_file,
+            rgb_transform const *aTransform = NULL, rgb_remap const *aRemap = NULL,
+            bool keyed = false);
+
+    // Patches rgb_file.  Returns false without touching it if the file
+    //  does not match the fingerprint.  A dry run only fills patches.
+    bool apply(string const &rgb_file, bool dry_run = false) {
+        return apply(rgb_file, patches, dry_run, threads);
+    }
+
+    // The same for a plan shared by several threads.  Large files are
+    //  scanned with up to aThreads threads.
+    bool apply(string const &rgb_file, vector<rgb_patch> &aPatches,
+            bool dry_run, unsigned int aThreads) const;
+
+    bool is_usable() const { return usable; }
+    uint64_t get_fingerprint() const { return fingerprint; }
+    size_t size() const { return targets.size(); }
+
+    // Passed on to the history config writer.
+    void set_timestamp(bool aTimestamp) { config_timestamp = aTimestamp; }
+
+    // Threads apply(rgb_file, dry_run) may use to scan one large file.
+    void set_threads(unsigned int aThreads) { threads = (aThreads > 0) ? aThreads : 1; }
+
+    // The colors changed by the last apply(), as in rgb_replace::plan.
+    vector<rgb_patch> patches;
+
+    // Where a color sits in a file: the red, green and blue words and
+    //  the node name.
+    struct color_span {
+        size_t begin[3];
+        size_t end[3];
+        string name;
+    };
+
+    // Maps a whole file read only.  False if it cannot be read, is empty
+    //  or holds a zero char, where rgb_fileio would stop reading.
+    static bool map_file(string const &file_name, rgb_mapped_file &mapping);
+
+    // Finds the first DEF and every color of the buffer_size chars at
+    //  buffer.  False if the file is not laid out the way replace()
+    //  expects.  A large buffer is split into up to threads chunks scanned
+    //  at once; the result is the same.
+    static bool scan(const char *buffer, size_t buffer_size, size_t &def_offset,
+            vector<color_span> &spans, uint64_t &file_fingerprint,
+            unsigned int threads = 1);
+
+    // The color of a span, parsed the same way as rgb_extract.
+    static rgb_node span_node(const char *buffer, color_span const &aSpan);
+
+    // One word of a span.
+    static string span_text(const char *buffer, color_span const &aSpan, int color) {
+        return string(buffer + aSpan.begin[color], aSpan.end[color] - aSpan.begin[color]);
+    }
+
+private:
+    static void add_name(rgb_hash &aHash, string const &aName);
+
+    enum scan_step { HEADER_VRML, HEADER_VER, HEADER_CHARSET, SEEK_DEF,
+        SEEK_DIFFUSECOLOR, RED, GREEN, BLUE };
+
+    // Where scan_range() stopped.
+    struct scan_state {
+        scan_state() : step(HEADER_VRML), def_offset(0), named(false), inherited(0) {}
+        scan_step step;
+        string last_word;
+        string node_name;
+        color_span aSpan;
+        size_t def_offset;
+        bool named;        // node_name was set in this range
+        size_t inherited;  // colors found before that
+    };
+
+    // Scans the words of buffer that end in [begin, end).  begin must be
+    //  the start of a word.
+    static bool scan_range(const char *buffer, size_t begin, size_t end,
+            scan_state &state, vector<color_span> &spans);
+
+    string config_file;
+    vector<string> names;
+    vector<rgb_node> targets;   // config colors after the transform and palette
+    vector<string> values;      // their text, "red green blue" split in three
+    uint64_t fingerprint;
+    bool palette;
+    bool usable;
+    bool config_timestamp;
+    unsigned int threads;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
@@ -0,0 +1,123 @@
+#ifndef __rgb_reduce_h__
+#define __rgb_reduce_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_reduce.h
+##  This file defines the object that reduces the colors of many files to
+##   a small palette with k-means.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#ifndef __rgb_extract_h__
+#include "rgb_extract.h"
+#endif
+
+#include <functional>
+#include <stdint.h>
+#include <unordered_map>
+
+const unsigned int CONST_REDUCE_DEFAULT_COLORS = 16;
+const unsigned int CONST_REDUCE_MAX_ITERATIONS = 100;
+const unsigned int CONST_REDUCE_SEED = 5489; // k-means++ seed, so runs repeat
+
+// Colors are streamed in with add_file() or add() and counted once per
+//  distinct color.  reduce() then runs weighted k-means in CIELAB (the
+//  same space as rgb_remap), seeded with k-means++.  The assignment step
+//  is split over the worker threads and compares each color with four
+//  centers per SSE2 instruction.
+class rgb_reduce
+{
+public:
+    rgb_reduce()
+    : STRING_error_layer("RGB_REDUCE") {
+        aLogger = LoggerLevel::getInstance();
+        threads = 0;
+        clear();
+    }
+
+    virtual ~rgb_reduce() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        counts.clear();
+        total = 0;
+        iterations = 0;
+    }
+
+    // 0 uses one thread per core.
+    void set_threads(unsigned int aThreads) { threads = aThreads; }
+
+    void add_file(string const &file_name);
+    void add(float red, float green, float blue, uint64_t weight = 1);
+
+    uint64_t colors_added() const { return total; }
+    size_t distinct_colors() const { return counts.size(); }
+
+    // The colors of the palette, at most aColors of them, named
+    //  "color_<n>" and sorted by how many nodes they stand for.
+    void reduce(unsigned int aColors, vector<rgb_node> &palette);
+
+    // Number of k-means steps taken by the last reduce().
+    unsigned int iterations;
+
+private:
+    struct color_key {
+        uint32_t bits[3];
+        bool operator == (color_key const &A) const {
+            return (bits[0] == A.bits[0]) && (bits[1] == A.bits[1]) &&
+                (bits[2] == A.bits[2]);
+        }
+    };
+
+    struct color_key_hash {
+        size_t operator()(color_key const &A) const {
+            uint64_t h = A.bits[0] * 0x9E3779B97F4A7C15ULL;
+            h ^= (h >> 29) + A.bits[1] * 0xC2B2AE3D27D4EB4FULL;
+            h ^= (h >> 32) + A.bits[2] * 0x165667B19E3779F9ULL;
+            return h ^ (h >> 31);
+        }
+    };
+
+    // Calls work(thread, begin, end) on every worker for its share of
+    //  [0, count).
+    void parallel_for(size_t count,
+            std::function<void(unsigned int, size_t, size_t)> const &work) const;
+    unsigned int worker_count() const;
+
+    unordered_map<color_key, uint64_t, color_key_hash> counts;
+    uint64_t total;
+    unsigned int threads;
+    rgb_extract extractor;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
@@ -0,0 +1,103 @@
+#ifndef __rgb_remap_h__
+#define __rgb_remap_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_remap.h
+##  This file defines the object that snaps colors to the nearest color of
+##   a fixed palette.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+// Colors are compared in CIELAB (D65 white, the node colors taken as
+//  sRGB) by their Euclidean distance (CIE76 delta E).  The palette is
+//  kept in a k-d tree over L*, a* and b*, so a lookup visits about
+//  log2(palette size) entries instead of all of them.
+class rgb_remap
+{
+public:
+    rgb_remap()
+    : STRING_error_layer("RGB_REMAP") {
+        aLogger = LoggerLevel::getInstance();
+        clear();
+    }
+
+    virtual ~rgb_remap() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        palette_file.clear();
+        colors.clear();
+        tree.clear();
+    }
+
+    // The palette is any config (text, palette, binary or bundle entry).
+    //  Only the distinct colors of its nodes are used.
+    void load(string const &aPaletteConfig);
+    void set_palette(vector<rgb_node> const &palette_nodes);
+
+    bool empty() const { return colors.empty(); }
+    size_t size() const { return colors.size(); }
+    string const &get_palette_file() const { return palette_file; }
+
+    // The palette color nearest to (red, green, blue).
+    rgb_node const &nearest(float red, float green, float blue) const;
+
+    // Copy of node_vector with every color snapped to the palette.
+    //  Names are kept.
+    void apply(vector<rgb_node> const &node_vector,
+            vector<rgb_node> &remapped) const;
+
+    // sRGB (0..1) to CIELAB and back.  from_lab() clamps colors that are
+    //  outside the sRGB gamut.
+    static void to_lab(float red, float green, float blue, float *lab);
+    static void from_lab(const float *lab, float &red, float &green, float &blue);
+
+private:
+    struct kd_node {
+        float lab[3];
+        unsigned int color; // position in colors
+        int axis;
+        int left;           // -1 if none
+        int right;
+    };
+
+    int build(vector<unsigned int> &order, vector<float> const &lab,
+            size_t begin, size_t end, int depth);
+    void search(int node, const float *lab, int &best, float &best_distance) const;
+
+    string palette_file;
+    vector<rgb_node> colors;
+    vector<kd_node> tree; // tree[0] is the root
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
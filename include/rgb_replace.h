@@ -40,6 +40,25 @@
 #include "rgb_configio.h"
 #endif
 
+#ifndef __rgb_transform_h__
+#include "rgb_transform.h"
+#endif
+
+#ifndef __rgb_remap_h__
+#include "rgb_remap.h"
+#endif
+
+
+// One color a replace would change.  offset and length give the bytes
+//  of the "red green blue" values in the source file as it is now.
+struct rgb_patch {
+    unsigned int index;  // diffuseColor number in the file
+    string name;         // node name (the word before Transform)
+    unsigned long long offset;
+    unsigned long long length;
+    string old_value;
+    string new_value;
+};
 
 class rgb_replace 
 : public rgb_state_char
@@ -50,6 +69,15 @@ public:
     , STRING_error_layer("RGB_REPLACE") {
         aLogger = LoggerLevel::getInstance();
         srcFileIO = NULL;
+        config_nodes = NULL;
+        config_index = 0;
+        replacement = NULL;
+        keyed = false;
+        match_by_name = false;
+        config_timestamp = true;
+        dry_run = false;
+        pipeline = NULL;
+        palette_map = NULL;
     }
 
     virtual ~rgb_replace() { 
@@ -62,13 +90,77 @@ public:
         word_accumulate.clear();
         srcFileIO = NULL;
         existing_node_config.clear();
-        config_node_vector.clear();
+        config_nodes = NULL;
+        config_index = 0;
+        replacement = NULL;
+        match_by_name = false;
+        adjusted_nodes.reset();
+        last_word.clear();
+        node_name.clear();
+        unmatched_source.clear();
+        unmatched_config.clear();
+        plan.clear();
+        old_value.clear();
+        read_offset = value_offset = 0;
         TRAN((STATE)&rgb_replace::STATE_verify_VRML);
     }
 
     void replace(string const &rgb_file, string const &rgb_config_file);
 
+    // Same as above with a config that has already been parsed.  The
+    //  config file name is only used in messages.
+    void replace(string const &rgb_file, rgb_node_table const &config_table,
+            string const &rgb_config_file);
+
+    // Runs the colors of the file itself through the transform and then
+    //  snaps them to the palette.  Either may be NULL.  Written in the same
+    //  single pass as a replace and rolled back the same way.
+    void recolor(string const &rgb_file, rgb_transform const *aTransform,
+            rgb_remap const *aRemap);
+
+    // When set, replace() runs the config colors through the transform
+    //  and then the palette before they are written.  Neither is owned by
+    //  rgb_replace.
+    void set_transform(rgb_transform const *aTransform) { pipeline = aTransform; }
+    void set_remap(rgb_remap const *aRemap) { palette_map = aRemap; }
+
+    // Keyed mode matches config nodes to file nodes by the DEF name
+    //  instead of by position.  File nodes without a config node keep
+    //  their colors.
+    void set_keyed(bool aKeyed) { keyed = aKeyed; }
+
+    // Leaves the "created" timestamp out of the history config written
+    //  into the file.
+    void set_timestamp(bool aTimestamp) { config_timestamp = aTimestamp; }
+
+    // A dry run reads the file and fills plan without writing anything.
+    void set_dry_run(bool aDryRun) { dry_run = aDryRun; }
+
+    // Filled by a keyed replace: node names found only in the file and
+    //  only in the config.
+    vector<string> unmatched_source;
+    vector<string> unmatched_config;
+
+    // Every color changed (or, in a dry run, that would be changed) by
+    //  the last replace, in file order.
+    vector<rgb_patch> plan;
+
 private:
+    // Fills adjusted_nodes with node_vector after the transform and the
+    //  palette.
+    void adjust(vector<rgb_node> const &node_vector, rgb_transform const *aTransform,
+            rgb_remap const *aRemap);
+
+    // Steps 3) to 10) of replace().  target_description names the new
+    //  colors in the "nothing to do" message.
+    void rewrite(string const &rgb_file, vector<rgb_node> const &source_node_vector,
+            bool palette, string const &target_description);
+
+    // Writes to the temp file unless this is a dry run.
+    void emit(string const &A);
+    void emit(char const &A);
+    void add_patch(string const &old_text, rgb_node const &aNode);
+
     // Verify its a VRML file
     void STATE_verify_VRML(const char &aChar);
     void STATE_verify_VRML_VER(const char &aChar);
@@ -89,7 +181,27 @@ private:
 
     rgb_fileio *srcFileIO;
     string existing_node_config;
-    vector<rgb_node> config_node_vector;
+    const rgb_node_table *config_nodes; // the config table or adjusted_nodes
+    unsigned int config_index;
+    const rgb_node *replacement;         // &replacement_node or NULL
+    rgb_node replacement_node;
+    bool keyed;
+    bool match_by_name;  // keyed, for the current replace() only
+    bool config_timestamp;
+    bool dry_run;
+    const rgb_transform *pipeline;
+    const rgb_remap *palette_map;
+    unique_ptr<rgb_node_table> adjusted_nodes; // config colors after adjust()
+
+    // Byte offset of the char being processed, where the red value of
+    //  the current color starts and its text before the replace.
+    unsigned long long read_offset;
+    unsigned long long value_offset;
+    string old_value;
+
+    // Name of the current node (the word before the Transform keyword).
+    string last_word;
+    string node_name;
 
     string STRING_error_layer;
     LoggerLevel *aLogger;
@@ -0,0 +1,104 @@
+#ifndef __rgb_schedule_h__
+#define __rgb_schedule_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_schedule.h
+##  This file defines the object that hands out files to worker threads,
+##   largest first.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+// Every worker has its own queue of tasks, kept largest first.  A new
+//  task goes to the worker with the fewest bytes queued or in hand, so a
+//  batch pushed in size order is spread the longest-processing-time-first
+//  way.  A worker takes the largest task of its own queue; when that is
+//  empty it steals the largest task of the worker with the most bytes
+//  left.  A few huge files then start at once and the small files fill
+//  in around them.
+//
+// Tasks are numbers given by the caller.  Sizes are only compared.
+class rgb_schedule
+{
+public:
+    rgb_schedule(unsigned int workers);
+
+    virtual ~rgb_schedule() {}
+
+    void push(size_t task, uint64_t size);
+
+    // No more tasks will be pushed.  pop() returns false once the queues
+    //  are empty.
+    void close();
+
+    // pop() returns false from now on.
+    void cancel();
+
+    // The next task for worker.  Waits while the queues are empty and
+    //  the schedule is still open.
+    bool pop(unsigned int worker, size_t &task);
+
+    // Workers waiting in pop() for a task or done.  A worker with a huge
+    //  file can use this many extra threads without taking cores from
+    //  anyone.
+    unsigned int idle() const { return idle_count; }
+
+    // Tasks taken from another worker's queue.
+    unsigned long stolen() const { return stolen_count; }
+
+private:
+    struct worker_queue {
+        worker_queue() : queued_bytes(0), running_bytes(0) {}
+        deque<pair<uint64_t, size_t> > tasks; // (size, task), largest first
+        uint64_t queued_bytes;
+        uint64_t running_bytes;
+        mutex queue_mutex;
+    };
+
+    // Takes the largest task of queue from into worker's hands.
+    bool take(unsigned int from, unsigned int worker, size_t &task);
+
+    unsigned int count;
+    unique_ptr<worker_queue[]> queues;
+    atomic<size_t> queued;     // tasks in all the queues
+    atomic<unsigned int> idle_count;
+    atomic<unsigned long> stolen_count;
+    bool closed;
+    bool cancelled;
+    mutex wait_mutex;          // guards closed and cancelled
+    condition_variable ready;
+};
+
+#endif
+
@@ -0,0 +1,121 @@
+#ifndef __rgb_transform_h__
+#define __rgb_transform_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_transform.h
+##  This file defines the object that compiles a color transform expression
+##   and applies it to RGB color columns.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+// A transform expression is a comma separated list of operators that are
+//  applied in order:
+//    hue=<degrees>         rotates the hue around the gray axis
+//    saturation=<percent>  +30 is 30% more saturated, -30 30% less
+//    desaturate=<percent>  same as saturation=-<percent>
+//    brightness=<factor>   scales all three colors
+//    gamma=<value>         color = color ^ (1 / value)
+//  e.g. "hue=+10,desaturate=30%,gamma=2.2"
+//
+// hue, saturation and brightness are 3x3 color matrices.  Colors are
+//  clamped to CONST_RGB_COLOR_VALUE_MIN/MAX after every operator.  A matrix
+//  is multiplied into the one before it when the expression is compiled,
+//  but only if the one before can not take a color out of range; the clamp
+//  between them would not change anything.
+class rgb_transform
+{
+public:
+    rgb_transform()
+    : STRING_error_layer("RGB_TRANSFORM") {
+        aLogger = LoggerLevel::getInstance();
+        clear();
+    }
+
+    rgb_transform(rgb_transform const &other)
+    : expression(other.expression)
+    , stages(other.stages)
+    , STRING_error_layer(other.STRING_error_layer) {
+        aLogger = LoggerLevel::getInstance();
+    }
+
+    virtual ~rgb_transform() {
+        aLogger->releaseInstance();
+    }
+
+    rgb_transform& operator = (rgb_transform const &A) {
+        expression = A.expression;
+        stages = A.stages;
+        return *this;
+    }
+
+    void clear() {
+        expression.clear();
+        stages.clear();
+    }
+
+    // Throws ENUM_UNEXPECTED_COMMAND_PARAMETER if anExpression is not valid.
+    void compile(string const &anExpression);
+
+    bool empty() const { return stages.empty(); }
+    string const &get_expression() const { return expression; }
+
+    // Runs every stage over the columns in place.
+    void apply(rgb_node_columns &columns) const;
+
+    // Transformed copy of node_vector.  Names are kept.
+    void apply(vector<rgb_node> const &node_vector,
+            vector<rgb_node> &transformed) const;
+
+private:
+    enum RGB_TRANSFORM_STAGE {
+         ENUM_TRANSFORM_MATRIX=0
+        ,ENUM_TRANSFORM_GAMMA
+    };
+
+    struct stage {
+        enum RGB_TRANSFORM_STAGE kind;
+        float matrix[9]; // row major, ENUM_TRANSFORM_MATRIX
+        float exponent;  // ENUM_TRANSFORM_GAMMA
+    };
+
+    void add_matrix(const float *aMatrix);
+    void add_gamma(float exponent);
+
+    void apply_matrix(const float *aMatrix, float *red, float *green, float *blue,
+            size_t count) const;
+    void apply_gamma(float exponent, float *column, size_t count) const;
+
+    string expression;
+    vector<stage> stages;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
@@ -0,0 +1,159 @@
+#ifndef __rgb_walk_h__
+#define __rgb_walk_h__
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_walk.h
+##  This file defines the object that walks a directory tree with several
+##   threads.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_h__
+#include "rgb_node.h"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// What the walk does with a symbolic link.  When links are followed each
+//  file and directory is visited once, however many ways it is reached.
+enum rgb_link_policy {
+     ENUM_LINKS_SKIP=0   // ignore every link
+    ,ENUM_LINKS_FILES    // follow links to files, not to directories
+    ,ENUM_LINKS_FOLLOW   // follow every link
+};
+
+// Directories waiting for a thread.  Past this a thread walks the
+//  directories it finds itself, so few descriptors are held open.
+const size_t CONST_WALK_MAX_PENDING = 256;
+
+// One regular file found by the walk.
+struct rgb_walk_entry {
+    string path;
+    uint64_t size;
+    int depth;     // 0: in the root directory
+};
+
+// walk() hands out directories to its threads.  Each directory is read
+//  through its own descriptor and every entry is looked at with
+//  fstatat()/openat() relative to it, so no path is resolved twice.  The
+//  d_type of an entry is trusted where the file system fills it in.
+//
+// found() is called from the walk threads as each file is found, before
+//  the walk is over, and must be thread safe.  The entries of a directory
+//  are visited in name order, so a walk with one thread always gives the
+//  files in the same order.
+class rgb_walk
+{
+public:
+    typedef std::function<bool(string const &)> name_filter;
+    typedef std::function<void(rgb_walk_entry const &)> file_found;
+
+    rgb_walk()
+    : STRING_error_layer("RGB_WALK") {
+        aLogger = LoggerLevel::getInstance();
+        threads = 0;
+        max_depth = -1;
+        links = ENUM_LINKS_SKIP;
+        clear();
+    }
+
+    virtual ~rgb_walk() {
+        aLogger->releaseInstance();
+    }
+
+    void clear() {
+        directories = 0;
+        unreadable = 0;
+        links_skipped = 0;
+        too_deep = 0;
+    }
+
+    // 0 uses one thread per core.
+    void set_threads(unsigned int aThreads) { threads = aThreads; }
+
+    // Directory levels entered below the root.  -1 has no limit.
+    void set_max_depth(int aDepth) { max_depth = aDepth; }
+    void set_links(rgb_link_policy aPolicy) { links = aPolicy; }
+
+    // Called with the name of every regular file before anything else is
+    //  done with it.  Files it returns false for are dropped.
+    void set_filter(name_filter const &aFilter) { filter = aFilter; }
+
+    void walk(string const &root, file_found const &found);
+
+    // Stops a walk in progress.  May be called from found().
+    void cancel() { stop = true; }
+
+    // Counts of the last walk.
+    atomic<unsigned long> directories;
+    atomic<unsigned long> unreadable;    // could not be opened or read
+    atomic<unsigned long> links_skipped;
+    atomic<unsigned long> too_deep;      // directories below max_depth
+
+private:
+    struct pending_directory {
+        int fd;
+        string path;
+        int depth;
+    };
+
+    // Reads one directory and closes fd.  Subdirectories are queued or,
+    //  when the queue is full, walked on this thread.
+    void read_directory(pending_directory const &aDirectory, file_found const &found);
+
+    // Opens the subdirectory name of parent_fd.  Returns -1 if it is not
+    //  to be entered.
+    int open_directory(int parent_fd, string const &name, bool follow);
+
+    // false if the file or directory (dev, ino) was already seen.
+    bool first_visit(struct stat const &info);
+
+    unsigned int worker_count() const;
+
+    unsigned int threads;
+    int max_depth;
+    rgb_link_policy links;
+    name_filter filter;
+
+    vector<pending_directory> pending;  // a stack, for depth first order
+    unsigned int busy;                  // threads reading a directory
+    atomic<bool> stop;                  // found() threw
+    mutex pending_mutex;
+    condition_variable pending_ready;
+    set<pair<dev_t, ino_t> > visited;   // only when links are followed
+    mutex visited_mutex;
+
+    string STRING_error_layer;
+    LoggerLevel *aLogger;
+};
+
+#endif
+
@@ -0,0 +1,539 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_binaryio.cpp
+##  This file defines the methods used to write and read binary RGB node files.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_binaryio_h__
+#include "include/rgb_binaryio.h"
+#endif
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Little-endian helpers.  These are byte based so the file layout does
+//  not depend on the host byte order.
+void rgb_binaryio::put_u32(char *out, uint32_t value)
+{
+    out[0] = (char)(value & 0xff);
+    out[1] = (char)((value >> 8) & 0xff);
+    out[2] = (char)((value >> 16) & 0xff);
+    out[3] = (char)((value >> 24) & 0xff);
+}
+
+void rgb_binaryio::put_u64(char *out, uint64_t value)
+{
+    put_u32(out, (uint32_t)(value & 0xffffffff));
+    put_u32(out + 4, (uint32_t)(value >> 32));
+}
+
+uint32_t rgb_binaryio::get_u32(const char *in)
+{
+    const unsigned char *p = (const unsigned char *)in;
+    return ((uint32_t)p[0]) |
+           ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+uint64_t rgb_binaryio::get_u64(const char *in)
+{
+    return ((uint64_t)get_u32(in)) | ((uint64_t)get_u32(in + 4) << 32);
+}
+
+void rgb_binaryio::put_f32(char *out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u32(out, bits);
+}
+
+float rgb_binaryio::get_f32(const char *in)
+{
+    uint32_t bits = get_u32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint64_t align_up(uint64_t value)
+{
+    return (value + CONST_BINARY_COLUMN_ALIGNMENT - 1) &
+        ~((uint64_t)CONST_BINARY_COLUMN_ALIGNMENT - 1);
+}
+
+static void write_padding(ofstream &out, uint64_t &position, uint64_t target)
+{
+    static const char zeros[CONST_BINARY_COLUMN_ALIGNMENT] = {0};
+    if (target > position) {
+        out.write(zeros, target - position);
+        position = target;
+    }
+}
+
+static void write_column(ofstream &out, uint64_t &position, vector<float> const &column)
+{
+    // Convert the floats in blocks so large columns are not copied all at once.
+    const unsigned int block = 4096;
+    char buffer[block * 4];
+
+    for (unsigned int ii = 0; ii < column.size(); ii += block) {
+        unsigned int count = column.size() - ii;
+        if (count > block) count = block;
+
+        for (unsigned int jj = 0; jj < count; jj++) {
+            rgb_binaryio::put_f32(buffer + (jj * 4), column[ii + jj]);
+        }
+        out.write(buffer, count * 4);
+        position += count * 4;
+    }
+}
+
+static bool host_is_little_endian()
+{
+    const uint32_t one = 1;
+    char first;
+    memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+static void read_column(const char *data, uint64_t offset, uint64_t count,
+        vector<float> &column)
+{
+    column.resize(count);
+    if (count == 0) return;
+
+    if (host_is_little_endian()) {
+        // The file is already in host order.
+        memcpy(&column[0], data + offset, count * 4);
+        return;
+    }
+    for (uint64_t ii = 0; ii < count; ii++) {
+        column[ii] = rgb_binaryio::get_f32(data + offset + (ii * 4));
+    }
+}
+
+void rgb_binaryio::write_node_binary_file(vector<rgb_node> const &node_vector,
+    string const &source_file,
+    string const &output_file)
+{
+    rgb_node_columns columns;
+    columns.assign(node_vector);
+    write_node_binary_file(columns, source_file, output_file);
+}
+
+void rgb_binaryio::write_node_binary_file(rgb_node_columns const &node_columns,
+    string const &source_file,
+    string const &output_file)
+{
+    uint64_t num_nodes = node_columns.size();
+
+    // Size the string table.  Node names first, then the source file name.
+    uint64_t names_size = 0;
+    for (uint64_t ii = 0; ii < num_nodes; ii++) {
+        names_size += node_columns.name[ii].size();
+    }
+
+    uint64_t name_index_offset = CONST_BINARY_HEADER_SIZE;
+    uint64_t string_table_offset = name_index_offset + ((num_nodes + 1) * 4);
+    uint64_t string_table_size = names_size + source_file.size();
+    uint64_t red_offset = align_up(string_table_offset + string_table_size);
+    uint64_t green_offset = align_up(red_offset + (num_nodes * 4));
+    uint64_t blue_offset = align_up(green_offset + (num_nodes * 4));
+    uint64_t file_size = blue_offset + (num_nodes * 4);
+
+    if (string_table_size > 0xffffffff) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Node names are too large for a binary node file.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    ofstream out_file(output_file.c_str(), ios::out | ios::trunc | ios::binary);
+    if (!out_file.is_open()) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to open binary node file \"" + output_file +
+            "\" for writing.  Is the directory full?",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    // Header
+    char header[CONST_BINARY_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, CONST_STRING_BINARY_MAGIC.data(), 8);
+    put_u32(header + 8, CONST_BINARY_CURRENT_VERSION);
+    put_u32(header + 12, CONST_BINARY_HEADER_SIZE);
+    put_u64(header + 16, num_nodes);
+    put_u64(header + 24, name_index_offset);
+    put_u64(header + 32, string_table_offset);
+    put_u64(header + 40, string_table_size);
+    put_u64(header + 48, red_offset);
+    put_u64(header + 56, green_offset);
+    put_u64(header + 64, blue_offset);
+    put_u64(header + 72, file_size);
+    put_u64(header + 80, string_table_offset + names_size);
+    put_u64(header + 88, source_file.size());
+    out_file.write(header, sizeof(header));
+    uint64_t position = sizeof(header);
+
+    // Name index.  Entry N holds the end of the last name.
+    char entry[4];
+    uint32_t name_offset = 0;
+    for (uint64_t ii = 0; ii < num_nodes; ii++) {
+        put_u32(entry, name_offset);
+        out_file.write(entry, sizeof(entry));
+        name_offset += node_columns.name[ii].size();
+    }
+    put_u32(entry, name_offset);
+    out_file.write(entry, sizeof(entry));
+    position += (num_nodes + 1) * 4;
+
+    // String table
+    for (uint64_t ii = 0; ii < num_nodes; ii++) {
+        out_file.write(node_columns.name[ii].data(), node_columns.name[ii].size());
+    }
+    out_file.write(source_file.data(), source_file.size());
+    position += string_table_size;
+
+    // Color columns
+    write_padding(out_file, position, red_offset);
+    write_column(out_file, position, node_columns.red);
+    write_padding(out_file, position, green_offset);
+    write_column(out_file, position, node_columns.green);
+    write_padding(out_file, position, blue_offset);
+    write_column(out_file, position, node_columns.blue);
+
+    out_file.close();
+    if (out_file.fail()) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to write binary node file \"" + output_file +
+            "\".  Is the directory full?",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+}
+
+void rgb_binaryio::read_node_binary_file(string const &input_file,
+    vector<rgb_node> &node_vector)
+{
+    rgb_node_columns columns;
+    string source_file;
+    read_node_binary_file(input_file, columns, source_file);
+    columns.to_nodes(node_vector);
+}
+
+void rgb_binaryio::read_node_binary_file(string const &input_file,
+    rgb_node_columns &node_columns,
+    string &source_file)
+{
+    ifstream in_file(input_file.c_str(), ios::in | ios::binary);
+    if (!in_file.is_open()) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
+            "Unable to open binary node file \"" + input_file + "\" for reading.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    // Read the whole file.  The columns are decoded straight from the buffer.
+    in_file.seekg(0, ios::end);
+    streamoff size = in_file.tellg();
+    in_file.seekg(0, ios::beg);
+    if (size < 0) size = 0;
+
+    vector<char> buffer(size);
+    if (size > 0) in_file.read(&buffer[0], size);
+    if (!in_file) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
+            "Unable to read binary node file \"" + input_file + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    decode(buffer.empty() ? NULL : &buffer[0], buffer.size(),
+        node_columns, source_file, input_file);
+}
+
+void rgb_binaryio::decode(const char *data, uint64_t size,
+    rgb_node_columns &node_columns,
+    string &source_file,
+    string const &input_file)
+{
+    node_columns.clear();
+    source_file.clear();
+
+    rgb_binary_header header;
+    read_header(data, size, header, input_file);
+
+    uint64_t num_nodes = header.num_nodes;
+    uint64_t name_index_offset = header.name_index_offset;
+    uint64_t string_table_offset = header.string_table_offset;
+    uint64_t string_table_size = header.string_table_size;
+
+    const char *strings = data + string_table_offset;
+    node_columns.name.reserve(num_nodes);
+    uint32_t start = get_u32(data + name_index_offset);
+    for (uint64_t ii = 0; ii < num_nodes; ii++) {
+        uint32_t end = get_u32(data + name_index_offset + ((ii + 1) * 4));
+        if ((end < start) || (end > string_table_size)) {
+            invalid(input_file, "corrupt name index");
+        }
+        node_columns.name.push_back(string(strings + start, end - start));
+        start = end;
+    }
+    source_file.assign(data + header.source_offset, header.source_size);
+
+    read_column(data, header.red_offset, num_nodes, node_columns.red);
+    read_column(data, header.green_offset, num_nodes, node_columns.green);
+    read_column(data, header.blue_offset, num_nodes, node_columns.blue);
+}
+
+void rgb_binaryio::read_header(const char *data, uint64_t size,
+    rgb_binary_header &header,
+    string const &input_file)
+{
+    header.clear();
+
+    if (!is_binary(data, size) || (size < CONST_BINARY_HEADER_SIZE)) {
+        invalid(input_file, "missing binary node file header");
+    }
+
+    uint32_t version = get_u32(data + 8);
+    uint32_t header_size = get_u32(data + 12);
+    header.num_nodes = get_u64(data + 16);
+    header.name_index_offset = get_u64(data + 24);
+    header.string_table_offset = get_u64(data + 32);
+    header.string_table_size = get_u64(data + 40);
+    header.red_offset = get_u64(data + 48);
+    header.green_offset = get_u64(data + 56);
+    header.blue_offset = get_u64(data + 64);
+    header.file_size = get_u64(data + 72);
+    header.source_offset = get_u64(data + 80);
+    header.source_size = get_u64(data + 88);
+
+    if (version != CONST_BINARY_CURRENT_VERSION) {
+        invalid(input_file, "unsupported binary node file version");
+    }
+    if ((header_size < CONST_BINARY_HEADER_SIZE) || (header.file_size != size)) {
+        invalid(input_file, "file size does not match the header");
+    }
+
+    // Every section must lie inside the file.  Divide rather than multiply
+    //  so a corrupt node count cannot overflow the checks.
+    uint64_t num_nodes = header.num_nodes;
+    uint64_t max_nodes = size / 4;
+    if ((num_nodes >= max_nodes) ||
+        (header.name_index_offset > size) ||
+        ((size - header.name_index_offset) / 4 < num_nodes + 1) ||
+        (header.string_table_offset > size) ||
+        (header.string_table_size > size - header.string_table_offset) ||
+        (header.source_offset < header.string_table_offset) ||
+        (header.source_offset > size) ||
+        (header.source_size > size - header.source_offset) ||
+        (header.red_offset > size) || ((size - header.red_offset) / 4 < num_nodes) ||
+        (header.green_offset > size) || ((size - header.green_offset) / 4 < num_nodes) ||
+        (header.blue_offset > size) || ((size - header.blue_offset) / 4 < num_nodes))
+    {
+        invalid(input_file, "section lies outside the file");
+    }
+}
+
+bool rgb_binaryio::is_binary(const char *data, uint64_t size)
+{
+    return (data != NULL) &&
+        (size >= CONST_STRING_BINARY_MAGIC.size()) &&
+        (memcmp(data, CONST_STRING_BINARY_MAGIC.data(),
+            CONST_STRING_BINARY_MAGIC.size()) == 0);
+}
+
+bool rgb_binaryio::is_binary_file(string const &file_name)
+{
+    ifstream in_file(file_name.c_str(), ios::in | ios::binary);
+    if (!in_file.is_open()) return false;
+
+    char magic[8];
+    in_file.read(magic, sizeof(magic));
+    return is_binary(magic, in_file.gcount());
+}
+
+void rgb_binaryio::invalid(string const &input_file, string const &reason)
+{
+    aLogger->throw_exception(ENUM_INVALID_BINARY_FILE,
+        "Binary node file \"" + input_file + "\" is invalid: " + reason + ".",
+        __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+}
+
+void rgb_mapped_file::open(string const &input_file)
+{
+    close();
+
+    int fd = ::open(input_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
+            "Unable to open \"" + input_file + "\" for reading.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
+            "Unable to read \"" + input_file + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    // An empty file cannot be mapped.  It is left as no data.
+    uint64_t file_size = file_stat.st_size;
+    void *mapping = MAP_FAILED;
+    if (file_size > 0) {
+        mapping = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+
+    if (file_size == 0) return;
+    if (mapping == MAP_FAILED) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
+            "Unable to map \"" + input_file + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    mapped_data = (const char *)mapping;
+    mapped_size = file_size;
+}
+
+void rgb_mapped_file::close()
+{
+    if (mapped_data) {
+        munmap((void *)mapped_data, mapped_size);
+    }
+    mapped_data = NULL;
+    mapped_size = 0;
+}
+
+void rgb_binary_view::open(string const &input_file)
+{
+    close();
+    file_name = input_file;
+
+    mapping.open(input_file);
+    data = mapping.data();
+    bytes = mapping.size();
+
+    try {
+        rgb_binaryio binaryIO;
+        binaryIO.read_header(data, bytes, header, input_file);
+    }
+    catch (...) {
+        close();
+        throw;
+    }
+}
+
+void rgb_binary_view::close()
+{
+    mapping.close();
+    data = NULL;
+    bytes = 0;
+    header.clear();
+}
+
+void rgb_binary_view::check_index(uint64_t index) const
+{
+    if (index >= header.num_nodes) {
+        aLogger->throw_exception(ENUM_INVALID_BINARY_FILE,
+            "Binary node file \"" + file_name + "\" has no such node.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+}
+
+string rgb_binary_view::name(uint64_t index) const
+{
+    check_index(index);
+
+    const char *name_index = data + header.name_index_offset + (index * 4);
+    uint32_t start = rgb_binaryio::get_u32(name_index);
+    uint32_t end = rgb_binaryio::get_u32(name_index + 4);
+    if ((end < start) || (end > header.string_table_size)) {
+        aLogger->throw_exception(ENUM_INVALID_BINARY_FILE,
+            "Binary node file \"" + file_name + "\" is invalid: corrupt name index.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    return string(data + header.string_table_offset + start, end - start);
+}
+
+float rgb_binary_view::red(uint64_t index) const
+{
+    check_index(index);
+    return rgb_binaryio::get_f32(data + header.red_offset + (index * 4));
+}
+
+float rgb_binary_view::green(uint64_t index) const
+{
+    check_index(index);
+    return rgb_binaryio::get_f32(data + header.green_offset + (index * 4));
+}
+
+float rgb_binary_view::blue(uint64_t index) const
+{
+    check_index(index);
+    return rgb_binaryio::get_f32(data + header.blue_offset + (index * 4));
+}
+
+const float *rgb_binary_view::red_column() const
+{
+    if (!data || !host_is_little_endian()) return NULL;
+    return reinterpret_cast<const float *>(data + header.red_offset);
+}
+
+const float *rgb_binary_view::green_column() const
+{
+    if (!data || !host_is_little_endian()) return NULL;
+    return reinterpret_cast<const float *>(data + header.green_offset);
+}
+
+const float *rgb_binary_view::blue_column() const
+{
+    if (!data || !host_is_little_endian()) return NULL;
+    return reinterpret_cast<const float *>(data + header.blue_offset);
+}
+
+string rgb_binary_view::source() const
+{
+    if (!data) return string();
+    return string(data + header.source_offset, header.source_size);
+}
+
+void rgb_binary_view::to_columns(rgb_node_columns &node_columns) const
+{
+    string source_file;
+    rgb_binaryio binaryIO;
+    binaryIO.decode(data, bytes, node_columns, source_file, file_name);
+}
+
+void rgb_binary_view::to_nodes(vector<rgb_node> &node_vector) const
+{
+    rgb_node_columns columns;
+    to_columns(columns);
+    columns.to_nodes(node_vector);
+}
@@ -0,0 +1,282 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_bundle.cpp
+##  This file defines the methods used to write and read config bundles.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_bundle_h__
+#include "include/rgb_bundle.h"
+#endif
+
+#ifndef __rgb_hash_h__
+#include "include/rgb_hash.h"
+#endif
+
+#include <cstdio>
+#include <cstring>
+
+// Everything after the last '/'.
+static string bundle_file_name(string const &source_file)
+{
+    size_t slash = source_file.rfind('/');
+    if (slash == string::npos) return source_file;
+    return source_file.substr(slash + 1);
+}
+
+void rgb_bundle::open(string const &bundle_file)
+{
+    close();
+    file_name = bundle_file;
+    mapping.open(bundle_file);
+
+    try {
+        read_index();
+    }
+    catch (...) {
+        close();
+        throw;
+    }
+}
+
+void rgb_bundle::close()
+{
+    mapping.close();
+    entries.clear();
+    file_names.clear();
+}
+
+size_t rgb_bundle::size() const
+{
+    size_t count = added.size();
+    for (auto const &ii : entries) {
+        if (added.find(ii.first) == added.end()) count++;
+    }
+    return count;
+}
+
+void rgb_bundle::read_index()
+{
+    const char *data = mapping.data();
+    uint64_t size = mapping.size();
+
+    if ((data == NULL) || (size < CONST_BUNDLE_HEADER_SIZE) ||
+        (memcmp(data, CONST_STRING_BUNDLE_MAGIC.data(),
+            CONST_STRING_BUNDLE_MAGIC.size()) != 0))
+    {
+        invalid("missing bundle header");
+    }
+
+    uint32_t version = rgb_binaryio::get_u32(data + 8);
+    uint32_t header_size = rgb_binaryio::get_u32(data + 12);
+    uint64_t num_entries = rgb_binaryio::get_u64(data + 16);
+    if (version != CONST_BUNDLE_CURRENT_VERSION) {
+        invalid("unsupported bundle version");
+    }
+    if ((header_size < CONST_BUNDLE_HEADER_SIZE) || (header_size > size)) {
+        invalid("header size is wrong");
+    }
+
+    // Divide so a corrupt entry count cannot overflow the check.
+    uint64_t position = header_size;
+    if ((size - position) / CONST_BUNDLE_ENTRY_SIZE < num_entries) {
+        invalid("index lies outside the file");
+    }
+
+    for (uint64_t ii = 0; ii < num_entries; ii++) {
+        if (size - position < CONST_BUNDLE_ENTRY_SIZE) {
+            invalid("index lies outside the file");
+        }
+        rgb_bundle_entry entry;
+        entry.offset = rgb_binaryio::get_u64(data + position);
+        entry.length = rgb_binaryio::get_u64(data + position + 8);
+        entry.hash = rgb_binaryio::get_u64(data + position + 16);
+        uint32_t path_length = rgb_binaryio::get_u32(data + position + 24);
+        position += CONST_BUNDLE_ENTRY_SIZE;
+
+        if ((path_length > size - position) ||
+            (entry.offset > size) || (entry.length > size - entry.offset))
+        {
+            invalid("index entry lies outside the file");
+        }
+        string source_file(data + position, path_length);
+        position += path_length;
+
+        entries[source_file] = entry;
+
+        // Remember which file names are unique.
+        string name = bundle_file_name(source_file);
+        auto found = file_names.find(name);
+        if (found == file_names.end()) {
+            file_names[name] = source_file;
+        }
+        else if (found->second != source_file) {
+            found->second.clear();
+        }
+    }
+}
+
+void rgb_bundle::find(string const &source_file, const char *&data, uint64_t &length) const
+{
+    auto new_config = added.find(source_file);
+    if (new_config != added.end()) {
+        data = new_config->second.data();
+        length = new_config->second.size();
+        return;
+    }
+
+    auto entry = entries.find(source_file);
+    if (entry == entries.end()) {
+        auto name = file_names.find(bundle_file_name(source_file));
+        if ((name != file_names.end()) && (!name->second.empty())) {
+            entry = entries.find(name->second);
+        }
+    }
+    if (entry == entries.end()) {
+        aLogger->throw_exception(ENUM_NOT_IN_BUNDLE,
+            "No config for \"" + source_file + "\" in bundle \"" + file_name + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    data = mapping.data() + entry->second.offset;
+    length = entry->second.length;
+    if (rgb_hash::hash(data, length) != entry->second.hash) {
+        invalid("config of \"" + entry->first + "\" does not match its hash");
+    }
+}
+
+void rgb_bundle::add(string const &source_file, string const &config_text)
+{
+    added[source_file] = config_text;
+}
+
+void rgb_bundle::write(string const &bundle_file)
+{
+    // Gather the configs in path order.  Configs from the opened bundle
+    //  are copied straight out of the mapping.
+    class rgb_bundle_item
+    {
+    public:
+        const string *source_file;
+        const char *data;
+        uint64_t length;
+    };
+    vector<rgb_bundle_item> items;
+    items.reserve(size());
+
+    auto old_entry = entries.begin();
+    auto new_config = added.begin();
+    while ((old_entry != entries.end()) || (new_config != added.end())) {
+        rgb_bundle_item item;
+        if ((new_config == added.end()) ||
+            ((old_entry != entries.end()) && (old_entry->first < new_config->first)))
+        {
+            item.source_file = &old_entry->first;
+            item.data = mapping.data() + old_entry->second.offset;
+            item.length = old_entry->second.length;
+            ++old_entry;
+        }
+        else {
+            if ((old_entry != entries.end()) && (old_entry->first == new_config->first)) {
+                ++old_entry;
+            }
+            item.source_file = &new_config->first;
+            item.data = new_config->second.data();
+            item.length = new_config->second.size();
+            ++new_config;
+        }
+        items.push_back(item);
+    }
+
+    // The configs start after the index.
+    uint64_t offset = CONST_BUNDLE_HEADER_SIZE;
+    for (auto const &ii : items) {
+        offset += CONST_BUNDLE_ENTRY_SIZE + ii.source_file->size();
+    }
+
+    string temp_file = bundle_file + CONST_STRING_DEFAULT_TEMP_FILE_EXTENTION;
+    ofstream out_file(temp_file.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!out_file.is_open()) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to open bundle \"" + temp_file +
+            "\" for writing.  Is the directory full?",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    char header[CONST_BUNDLE_HEADER_SIZE];
+    memcpy(header, CONST_STRING_BUNDLE_MAGIC.data(), 8);
+    rgb_binaryio::put_u32(header + 8, CONST_BUNDLE_CURRENT_VERSION);
+    rgb_binaryio::put_u32(header + 12, CONST_BUNDLE_HEADER_SIZE);
+    rgb_binaryio::put_u64(header + 16, items.size());
+    out_file.write(header, sizeof(header));
+
+    char entry[CONST_BUNDLE_ENTRY_SIZE];
+    for (auto const &ii : items) {
+        rgb_binaryio::put_u64(entry, offset);
+        rgb_binaryio::put_u64(entry + 8, ii.length);
+        rgb_binaryio::put_u64(entry + 16, rgb_hash::hash(ii.data, ii.length));
+        rgb_binaryio::put_u32(entry + 24, ii.source_file->size());
+        out_file.write(entry, sizeof(entry));
+        out_file.write(ii.source_file->data(), ii.source_file->size());
+        offset += ii.length;
+    }
+
+    for (auto const &ii : items) {
+        out_file.write(ii.data, ii.length);
+    }
+
+    out_file.close();
+    if (out_file.fail()) {
+        remove(temp_file.c_str());
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to write bundle \"" + temp_file + "\".  Is the directory full?",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    // The old bundle stays mapped until close(); rename() only unlinks it.
+    if (rename(temp_file.c_str(), bundle_file.c_str()) != 0) {
+        remove(temp_file.c_str());
+        aLogger->throw_exception(ENUM_UNABLE_TO_RENAME_TEMP,
+            "Unable to rename \"" + temp_file + "\" to \"" + bundle_file + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+}
+
+bool rgb_bundle::is_bundle_file(string const &file_name)
+{
+    ifstream in_file(file_name.c_str(), ios::in | ios::binary);
+    if (!in_file.is_open()) return false;
+
+    char magic[8];
+    in_file.read(magic, sizeof(magic));
+    return (in_file.gcount() == (streamsize)sizeof(magic)) &&
+        (memcmp(magic, CONST_STRING_BUNDLE_MAGIC.data(), sizeof(magic)) == 0);
+}
+
+void rgb_bundle::invalid(string const &reason) const
+{
+    aLogger->throw_exception(ENUM_INVALID_BUNDLE_FILE,
+        "Bundle \"" + file_name + "\" is invalid: " + reason + ".",
+        __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+}
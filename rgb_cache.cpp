@@ -0,0 +1,243 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_cache.cpp
+##  This file defines the methods used to load, query, evict and save the
+##   persistent RGB node cache.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_cache_h__
+#include "include/rgb_cache.h"
+#endif
+
+#ifndef __rgb_binaryio_h__
+#include "include/rgb_binaryio.h"
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// Fixed part of the cache file header and of each entry.
+static const uint64_t CACHE_HEADER_SIZE = 32;
+static const uint64_t CACHE_ENTRY_HEADER_SIZE = 28;
+
+uint64_t rgb_cache::entry_bytes(rgb_node_columns const &nodes)
+{
+    // Bytes this entry takes in the cache file.
+    uint64_t bytes = CACHE_ENTRY_HEADER_SIZE;
+    for (unsigned int ii = 0; ii < nodes.size(); ii++) {
+        bytes += 4 + nodes.name[ii].size() + 12;
+    }
+    return bytes;
+}
+
+void rgb_cache::open(string const &file_name)
+{
+    clear();
+    cache_file = file_name;
+
+    ifstream in_file(file_name.c_str(), ios::in | ios::binary);
+    if (!in_file.is_open()) {
+        // No cache yet.  It will be created by save().
+        return;
+    }
+
+    vector<char> buffer((istreambuf_iterator<char>(in_file)), istreambuf_iterator<char>());
+    const char *data = buffer.empty() ? NULL : &buffer[0];
+    uint64_t size = buffer.size();
+
+    if ((size < CACHE_HEADER_SIZE) ||
+        (memcmp(data, CONST_STRING_CACHE_MAGIC.data(), 8) != 0) ||
+        (rgb_binaryio::get_u32(data + 8) != CONST_CACHE_CURRENT_VERSION))
+    {
+        // Not a cache file we understand.  Start over; save() replaces it.
+        dirty = true;
+        return;
+    }
+
+    use_clock = rgb_binaryio::get_u64(data + 16);
+    uint64_t count = rgb_binaryio::get_u64(data + 24);
+    uint64_t position = CACHE_HEADER_SIZE;
+
+    for (uint64_t ii = 0; ii < count; ii++)
+    {
+        if (size - position < CACHE_ENTRY_HEADER_SIZE) break;
+
+        cache_key key(rgb_binaryio::get_u64(data + position),
+            rgb_binaryio::get_u64(data + position + 8));
+        cache_entry entry;
+        entry.last_use = rgb_binaryio::get_u64(data + position + 16);
+        uint32_t num_nodes = rgb_binaryio::get_u32(data + position + 24);
+        position += CACHE_ENTRY_HEADER_SIZE;
+
+        bool truncated = false;
+        for (uint32_t jj = 0; jj < num_nodes; jj++)
+        {
+            if (size - position < 4) { truncated = true; break; }
+            uint32_t name_size = rgb_binaryio::get_u32(data + position);
+            position += 4;
+            if (size - position < (uint64_t)name_size + 12) { truncated = true; break; }
+
+            entry.nodes.name.push_back(string(data + position, name_size));
+            position += name_size;
+            entry.nodes.red.push_back(rgb_binaryio::get_f32(data + position));
+            entry.nodes.green.push_back(rgb_binaryio::get_f32(data + position + 4));
+            entry.nodes.blue.push_back(rgb_binaryio::get_f32(data + position + 8));
+            position += 12;
+        }
+
+        if (truncated) {
+            // Keep what was read before the damage and rewrite the file.
+            dirty = true;
+            break;
+        }
+
+        entry.bytes = entry_bytes(entry.nodes);
+        total_bytes += entry.bytes;
+        entries[key] = entry;
+    }
+}
+
+bool rgb_cache::lookup(uint64_t hash, uint64_t size, rgb_node_columns &nodes)
+{
+    lock_guard<mutex> lock(entries_mutex);
+    map<cache_key, cache_entry>::iterator it = entries.find(cache_key(hash, size));
+    if (it == entries.end()) {
+        misses++;
+        return false;
+    }
+
+    hits++;
+    it->second.last_use = ++use_clock;
+    nodes = it->second.nodes;
+    dirty = true;
+    return true;
+}
+
+void rgb_cache::store(uint64_t hash, uint64_t size, rgb_node_columns const &nodes)
+{
+    lock_guard<mutex> lock(entries_mutex);
+    cache_entry &entry = entries[cache_key(hash, size)];
+    total_bytes -= entry.bytes;
+
+    entry.last_use = ++use_clock;
+    entry.nodes = nodes;
+    entry.bytes = entry_bytes(nodes);
+    total_bytes += entry.bytes;
+
+    stores++;
+    dirty = true;
+}
+
+void rgb_cache::evict()
+{
+    if (total_bytes <= size_limit) return;
+
+    // Least recently used first.
+    vector<pair<uint64_t, cache_key> > by_age;
+    for (map<cache_key, cache_entry>::const_iterator it = entries.begin();
+        it != entries.end(); it++)
+    {
+        by_age.push_back(make_pair(it->second.last_use, it->first));
+    }
+    sort(by_age.begin(), by_age.end());
+
+    for (unsigned int ii = 0; (ii < by_age.size()) && (total_bytes > size_limit); ii++)
+    {
+        map<cache_key, cache_entry>::iterator it = entries.find(by_age[ii].second);
+        total_bytes -= it->second.bytes;
+        entries.erase(it);
+        evictions++;
+        dirty = true;
+    }
+}
+
+void rgb_cache::save()
+{
+    evict();
+
+    if (!dirty || cache_file.empty()) return;
+
+    // Write a temp file and rename it so an interrupted run never leaves
+    //  a half written cache behind.
+    string temp_file_name = cache_file + CONST_STRING_DEFAULT_TEMP_FILE_EXTENTION;
+    ofstream out_file(temp_file_name.c_str(), ios::out | ios::trunc | ios::binary);
+    if (!out_file.is_open()) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to open cache file \"" + temp_file_name + "\" for writing.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    char header[CACHE_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, CONST_STRING_CACHE_MAGIC.data(), 8);
+    rgb_binaryio::put_u32(header + 8, CONST_CACHE_CURRENT_VERSION);
+    rgb_binaryio::put_u64(header + 16, use_clock);
+    rgb_binaryio::put_u64(header + 24, entries.size());
+    out_file.write(header, sizeof(header));
+
+    string record;
+    for (map<cache_key, cache_entry>::const_iterator it = entries.begin();
+        it != entries.end(); it++)
+    {
+        rgb_node_columns const &nodes = it->second.nodes;
+        record.resize(it->second.bytes);
+        char *p = &record[0];
+
+        rgb_binaryio::put_u64(p, it->first.first);
+        rgb_binaryio::put_u64(p + 8, it->first.second);
+        rgb_binaryio::put_u64(p + 16, it->second.last_use);
+        rgb_binaryio::put_u32(p + 24, nodes.size());
+        p += CACHE_ENTRY_HEADER_SIZE;
+
+        for (unsigned int ii = 0; ii < nodes.size(); ii++) {
+            rgb_binaryio::put_u32(p, nodes.name[ii].size());
+            p += 4;
+            memcpy(p, nodes.name[ii].data(), nodes.name[ii].size());
+            p += nodes.name[ii].size();
+            rgb_binaryio::put_f32(p, nodes.red[ii]);
+            rgb_binaryio::put_f32(p + 4, nodes.green[ii]);
+            rgb_binaryio::put_f32(p + 8, nodes.blue[ii]);
+            p += 12;
+        }
+        out_file.write(record.data(), record.size());
+    }
+
+    out_file.close();
+    if (out_file.fail() || (rename(temp_file_name.c_str(), cache_file.c_str()) != 0)) {
+        remove(temp_file_name.c_str());
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to write cache file \"" + cache_file + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    dirty = false;
+}
+
+void rgb_cache::print_statistics(ostream &out) const
+{
+    out << "Cache : " << hits << " hits, " << misses << " misses, "
+        << stores << " stored, " << evictions << " evicted, "
+        << entries.size() << " entries" << endl;
+}
@@ -31,6 +31,14 @@
 #include "include/rgb_cmdline.h"
 #endif
 
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 void rgb_cmdline::parse_execute(const int &argc, char *argv[])
 {
 DEBUG_METHOD_COUT
@@ -72,6 +80,7 @@ DEBUG_METHOD_COUT
             }
             cout << endl;
             (*it)->process();
+            (*it)->report();
         }
     }
     catch (ErrException& caught)
@@ -194,6 +203,14 @@ DEBUG_METHOD_COUT
     // Verify the expected command switch.
     nothing_required(aCmdParam);
 
+    // "-files-from <list|->" in place of the first parameter.
+    if (accepts_file_list &&
+        optional_switch_value(aCmdParam, "-files-from", STRING_file_list))
+    {
+        p1 = STRING_file_list;
+        return;
+    }
+
     // Extract required first parameter ...
     // IF the parameter list isnt empty 
     //   AND the first parameter doesnt start with a dash
@@ -280,12 +297,493 @@ DEBUG_METHOD_COUT
     }
 }
 
+void rgb_cmdline::rgb_command::optional_switches(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    // Let the command consume as many of its options as it recognizes.
+    //  Anything else is left for the next command.
+    while ((!aCmdParam.empty()) && option(aCmdParam))
+    {
+    }
+}
+
+bool rgb_cmdline::rgb_command::optional_switch(vector<string> &aCmdParam, 
+    string const &aSwitch)
+{
+DEBUG_METHOD_COUT
+    if ((!aCmdParam.empty()) && (aCmdParam[0] == aSwitch))
+    {
+        aCmdParam.erase(aCmdParam.begin());
+        return true;
+    }
+    return false;
+}
+
+bool rgb_cmdline::rgb_command::optional_switch_value(vector<string> &aCmdParam,
+    string const &aSwitch, string &aValue)
+{
+DEBUG_METHOD_COUT
+    if ((aCmdParam.empty()) || (aCmdParam[0] != aSwitch))
+    {
+        return false;
+    }
+
+    // The switch needs a value after it.
+    if ((aCmdParam.size() < 2) || (aCmdParam[1].empty()))
+    {
+        aLogger->throw_exception(ENUM_MISSING_SECOND_PARAMETER,
+            " \"" + aSwitch + "\" found but its value is missing.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    aValue = aCmdParam[1];
+    aCmdParam.erase(aCmdParam.begin(), aCmdParam.begin() + 2);
+    return true;
+}
+
+bool rgb_cmdline::rgb_command::cache_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    string aValue;
+    if (optional_switch_value(aCmdParam, "-cache", STRING_cache_file))
+    {
+        return true;
+    }
+    if (optional_switch_value(aCmdParam, "-cache-size", aValue))
+    {
+        char *end = NULL;
+        cache_size_mb = strtoul(aValue.c_str(), &end, 10);
+        if ((*end != '\0') || (aValue[0] == '-'))
+        {
+            aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                "Invalid cache size \"" + aValue + "\".  Expected a number of megabytes.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool rgb_cmdline::rgb_command::timestamp_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    if (optional_switch(aCmdParam, "-no-timestamp"))
+    {
+        config_timestamp = false;
+        return true;
+    }
+    return false;
+}
+
+bool rgb_cmdline::rgb_command::palette_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    if (optional_switch(aCmdParam, "-palette"))
+    {
+        config_palette = true;
+        return true;
+    }
+    return false;
+}
+
+bool rgb_cmdline::rgb_command::tolerance_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    string aValue;
+    if (!optional_switch_value(aCmdParam, "-tolerance", aValue))
+    {
+        return false;
+    }
+
+    const string ulp_suffix("ulp");
+    char *end = NULL;
+
+    if ((aValue.size() > ulp_suffix.size()) &&
+        (aValue.compare(aValue.size() - ulp_suffix.size(), ulp_suffix.size(), ulp_suffix) == 0))
+    {
+        // Tolerance in units in the last place.
+        string number(aValue, 0, aValue.size() - ulp_suffix.size());
+        unsigned long ulps = strtoul(number.c_str(), &end, 10);
+        if ((*end == '\0') && (number[0] != '-')) {
+            comparator.set_ulp_tolerance(ulps);
+            return true;
+        }
+    }
+    else
+    {
+        // Absolute tolerance.
+        float tolerance = strtof(aValue.c_str(), &end);
+        if ((*end == '\0') && (tolerance >= 0.0)) {
+            comparator.set_absolute_tolerance(tolerance);
+            return true;
+        }
+    }
+
+    aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+        "Invalid tolerance \"" + aValue + "\".  Expected a value such as \"1e-6\" or \"4ulp\".",
+        __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    return false;
+}
+
+bool rgb_cmdline::rgb_command::remap_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    string aValue;
+    if (!optional_switch_value(aCmdParam, "-remap", aValue))
+    {
+        return false;
+    }
+
+    if (!is_regular_file(path(aValue)))
+    {
+        aLogger->throw_exception(ENUM_FILE_OR_DIRECTORY_NOT_FOUND,
+            "Palette \"" + aValue + "\" does not exist.  Check the path or filename.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    remap.load(aValue);
+    STRING_remap_file = aValue;
+    return true;
+}
+
+bool rgb_cmdline::rgb_command::dry_run_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    if (optional_switch(aCmdParam, "-dry-run"))
+    {
+        dry_run = true;
+        return true;
+    }
+    return false;
+}
+
+void rgb_cmdline::rgb_command::print_plan(ostream &out, vector<rgb_patch> const &plan)
+{
+DEBUG_METHOD_COUT
+    // "node name @offset+length : old -> new"
+    out << " - PLAN (" << plan.size() << " changes)" << endl;
+    for (unsigned int ii = 0; ii < plan.size(); ii++) {
+        out << "  " << plan[ii].index << " " << plan[ii].name
+            << " @" << plan[ii].offset << "+" << plan[ii].length
+            << " : " << plan[ii].old_value << " -> " << plan[ii].new_value << endl;
+    }
+}
+
+bool rgb_cmdline::rgb_command::jobs_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    string aValue;
+    if (optional_switch_value(aCmdParam, "-jobs", aValue))
+    {
+        char *end = NULL;
+        jobs = strtoul(aValue.c_str(), &end, 10);
+        if ((*end != '\0') || (aValue[0] == '-'))
+        {
+            aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                "Invalid job count \"" + aValue + "\".  Expected a number (0 for one per core).",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool rgb_cmdline::rgb_command::recursive_option(vector<string> &aCmdParam)
+{
+DEBUG_METHOD_COUT
+    if (optional_switch(aCmdParam, "-recursive"))
+    {
+        recursive = true;
+        return true;
+    }
+
+    string aValue;
+    if (optional_switch_value(aCmdParam, "-max-depth", aValue))
+    {
+        char *end = NULL;
+        unsigned long depth = strtoul(aValue.c_str(), &end, 10);
+        if ((*end != '\0') || (aValue[0] == '-') || (depth > INT_MAX))
+        {
+            aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                "Invalid depth \"" + aValue + "\".  Expected a number (0 for the directory only).",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        walker.set_max_depth(depth);
+        return true;
+    }
+
+    if (optional_switch_value(aCmdParam, "-links", aValue))
+    {
+        if (aValue == "skip") {
+            walker.set_links(ENUM_LINKS_SKIP);
+        } else if (aValue == "files") {
+            walker.set_links(ENUM_LINKS_FILES);
+        } else if (aValue == "follow") {
+            walker.set_links(ENUM_LINKS_FOLLOW);
+        } else {
+            aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                "Invalid link policy \"" + aValue + "\".  Expected skip, files or follow.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        return true;
+    }
+    return false;
+}
+
+unsigned int rgb_cmdline::rgb_command::requested_workers() const
+{
+    unsigned int workers = jobs;
+    if (workers == 0) workers = std::thread::hardware_concurrency();
+    return (workers > 0) ? workers : 1;
+}
+
+unsigned int rgb_cmdline::rgb_command::worker_count() const
+{
+    unsigned int workers = requested_workers();
+
+    // The number of files a walk or a list gives is not known up front.
+    if (!streamed() && (workers > input_file_pairs.size())) {
+        workers = input_file_pairs.size();
+    }
+    return (workers > 0) ? workers : 1;
+}
+
+unsigned int rgb_cmdline::rgb_command::spare_workers() const
+{
+    unsigned int spare = requested_workers() - worker_count();
+    rgb_schedule *aSchedule = schedule;
+    if (aSchedule) spare += aSchedule->idle();
+    return spare;
+}
+
+void rgb_cmdline::rgb_command::for_each_pair(file_work const &work)
+{
+DEBUG_METHOD_COUT
+    files_processed = 0;
+    unsigned int workers = worker_count();
+    if ((workers == 1) && !streamed())
+    {
+        for (rgb_param_pair const &ii : input_file_pairs) {
+            work(ii, cout, 0);
+            files_processed++;
+        }
+        return;
+    }
+
+    // One slot per file.  The workers fill them in any order and this
+    //  thread prints them in the order they were queued.  Printed slots
+    //  are dropped from the front; slot ii is slots[ii - first].
+    struct file_slot {
+        file_slot(rgb_param_pair const &A) : pair(A), done(false) {}
+        rgb_param_pair pair;
+        string text;
+        bool done;
+        exception_ptr failure; // anything work() did not catch itself
+    };
+    deque<file_slot> slots;
+    size_t first = 0;
+    bool queued_all = !streamed();
+    bool stop = false;
+    mutex slot_mutex;
+    condition_variable slot_changed;
+
+    // The files are handed out largest first (see rgb_schedule).
+    rgb_schedule aSchedule(workers);
+    vector<pair<uint64_t, size_t> > by_size;
+    for (size_t ii = 0; ii < input_file_pairs.size(); ii++)
+    {
+        slots.push_back(file_slot(input_file_pairs[ii]));
+        boost::system::error_code ec;
+        uint64_t size = file_size(input_file_pairs[ii].path1, ec);
+        by_size.push_back(make_pair(ec ? 0 : size, ii));
+    }
+    stable_sort(by_size.begin(), by_size.end(),
+        [](pair<uint64_t, size_t> const &A, pair<uint64_t, size_t> const &B) {
+            return A.first > B.first; });
+    for (size_t ii = 0; ii < by_size.size(); ii++) {
+        aSchedule.push(by_size[ii].second, by_size[ii].first);
+    }
+    if (queued_all) aSchedule.close();
+    schedule = &aSchedule;
+
+    auto run = [&](unsigned int worker) {
+        size_t ii;
+        while (aSchedule.pop(worker, ii))
+        {
+            rgb_param_pair aPair;
+            {
+                lock_guard<mutex> lock(slot_mutex);
+                aPair = slots[ii - first].pair;
+            }
+
+            ostringstream out;
+            exception_ptr failure;
+            try {
+                work(aPair, out, worker);
+            } catch (...) {
+                failure = current_exception();
+            }
+
+            lock_guard<mutex> lock(slot_mutex);
+            slots[ii - first].text = out.str();
+            slots[ii - first].failure = failure;
+            slots[ii - first].done = true;
+            slot_changed.notify_all();
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned int ww = 0; ww < workers; ww++) {
+        pool.push_back(thread(run, ww));
+    }
+
+    // Queues a file found by the walk or read from the list.  False once
+    //  the run is stopping.
+    auto queue_file = [&](rgb_param_pair const &aPair, uint64_t size) {
+        size_t ii;
+        {
+            lock_guard<mutex> lock(slot_mutex);
+            if (stop) return false;
+            ii = first + slots.size();
+            slots.push_back(file_slot(aPair));
+            slot_changed.notify_all();
+        }
+        aSchedule.push(ii, size);
+        return true;
+    };
+
+    // The walk or the list queues each VRML file as soon as it is found.
+    exception_ptr walk_failure;
+    thread producer;
+    if (streamed())
+    {
+        producer = thread([&]() {
+            try {
+                if (!STRING_walk_root.empty())
+                {
+                    walker.set_threads(jobs);
+                    walker.set_filter([this](string const &aName) {
+                        return vrml_extension_wanted(aName); });
+                    walker.walk(STRING_walk_root, [&](rgb_walk_entry const &anEntry) {
+                        path aPath(anEntry.path);
+                        if (!vrml_header_wanted(aPath)) return;
+                        if (!queue_file(rgb_param_pair(aPath, STRING_walk_config), anEntry.size)) {
+                            walker.cancel();
+                        }
+                    });
+                }
+                else
+                {
+                    string aPath;
+                    string aConfig;
+                    uint64_t size;
+                    file_list.open(STRING_file_list);
+                    // A listed file is processed as if it were named on
+                    //  the command line: it is not filtered by extension
+                    //  or header, so a file that is not VRML is reported.
+                    while (file_list.next(aPath, aConfig, size))
+                    {
+                        if (aConfig.empty()) aConfig = STRING_walk_config;
+                        if (!queue_file(rgb_param_pair(aPath, aConfig), size)) break;
+                    }
+                }
+            } catch (...) {
+                walk_failure = current_exception();
+            }
+
+            {
+                lock_guard<mutex> lock(slot_mutex);
+                queued_all = true;
+                slot_changed.notify_all();
+            }
+            aSchedule.close();
+        });
+    }
+
+    // As in a serial run, an uncaught error stops the run after the
+    //  output of the file that raised it.
+    exception_ptr failure;
+    for (;;)
+    {
+        string text;
+        {
+            unique_lock<mutex> lock(slot_mutex);
+            slot_changed.wait(lock, [&]() {
+                return slots.empty() ? queued_all : slots.front().done; });
+            if (slots.empty()) break;
+            text.swap(slots.front().text);
+            failure = slots.front().failure;
+            slots.pop_front();
+            first++;
+            if (failure) stop = true;
+        }
+        cout << text << flush;
+        files_processed++;
+        if (failure) {
+            aSchedule.cancel();
+            break;
+        }
+    }
+
+    for (unsigned int ww = 0; ww < workers; ww++) {
+        pool[ww].join();
+    }
+    if (producer.joinable()) producer.join();
+    schedule = NULL;
+
+    if (failure) rethrow_exception(failure);
+    if (walk_failure) rethrow_exception(walk_failure);
+    if (files_processed == 0)
+    {
+        aLogger->throw_exception(ENUM_NO_FILES_FOUND_IN_DIRECTORY,
+            "No VRML files found in \"" + STRING_param_one + "\".  Nothing to do.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+}
+
+void rgb_cmdline::rgb_command::cache_open(rgb_cache &aCache, rgb_extract &anExtractObj)
+{
+DEBUG_METHOD_COUT
+    if (STRING_cache_file.empty()) return;
+
+    aCache.set_size_limit((uint64_t)cache_size_mb * 1024 * 1024);
+    aCache.open(STRING_cache_file);
+    anExtractObj.set_cache(&aCache);
+}
+
+void rgb_cmdline::rgb_command::cache_close(rgb_cache &aCache)
+{
+DEBUG_METHOD_COUT
+    if (STRING_cache_file.empty()) return;
+
+    aCache.save();
+    aCache.print_statistics(cout);
+}
+
 void rgb_cmdline::rgb_command::first_path_must_exist(string const &p1, vector<path> &path_listing)
 {
 DEBUG_METHOD_COUT
     // Clear the file pairs
     path_listing.clear();
 
+    // for_each_pair() reads the list and processes the files as they
+    //  are read.
+    if (!STRING_file_list.empty())
+    {
+        if (recursive)
+        {
+            aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                "-recursive cannot be used with -files-from.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        if ((STRING_file_list != "-") && !is_regular_file(path(STRING_file_list)))
+        {
+            aLogger->throw_exception(ENUM_FILE_OR_DIRECTORY_NOT_FOUND,
+                "File list \"" + STRING_file_list + "\" does not exist.  Check the path or filename.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        return;
+    }
+
     // Is p1 exist
     path path1(p1);
     if (!exists(path1))
@@ -303,6 +801,13 @@ DEBUG_METHOD_COUT
         // Its a regular file. Push it into the file pair vector
         path_listing.push_back(path1);
     } 
+    else if (is_directory(path1) && recursive)
+    {
+        // for_each_pair() walks the tree and processes the files as
+        //  they are found.
+        STRING_walk_root = p1;
+        return;
+    }
     else if (is_directory(path1))
     {
         // Its a directory ... get a listing of everything
@@ -310,9 +815,9 @@ DEBUG_METHOD_COUT
         copy(directory_iterator(path1), directory_iterator(),
                 back_inserter(list_of_directory_elements));
 
-        // Now sort out the regular files from everything else.
+        // Now sort out the regular VRML files from everything else.
         for(path ii : list_of_directory_elements) {
-            if (is_regular_file(ii)) {
+            if (is_regular_file(ii) && vrml_file_wanted(ii)) {
                 // Push the listing of regular files into the 
                 //  file pairs vector.
                 path_listing.push_back(ii);
@@ -330,15 +835,98 @@ DEBUG_METHOD_COUT
     // Did we find any regular files in the P1 directory?
     if (path_listing.empty())
     {
-        // No regular files found... nothing to do.
+        // No regular VRML files found... nothing to do.
         aLogger->throw_exception(ENUM_NO_FILES_FOUND_IN_DIRECTORY,
-            "No files found in \"" + p1 + "\".  Nothing to do.", 
+            "No VRML files found in \"" + p1 + "\".  Nothing to do.", 
             __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
     }
 
 
 }
 
+bool rgb_cmdline::rgb_command::vrml_file_wanted(path const &aPath)
+{
+DEBUG_METHOD_COUT
+    // Cheap checks before any parser sees the file.  First the extention
+    //  (case insensitive) and then the first bytes of the file.
+    return vrml_extension_wanted(aPath.filename().string()) &&
+        vrml_header_wanted(aPath);
+}
+
+bool rgb_cmdline::rgb_command::vrml_extension_wanted(string const &aName)
+{
+DEBUG_METHOD_COUT
+    string extention = path(aName).extension().string();
+    for (unsigned int ii = 0; ii < extention.size(); ii++) {
+        extention[ii] = tolower(extention[ii]);
+    }
+    if ((extention != CONST_STRING_VRML_FILE_EXTENTION) &&
+        (extention != CONST_STRING_VRML_ALT_FILE_EXTENTION))
+    {
+        skipped_extension++;
+        return false;
+    }
+    return true;
+}
+
+bool rgb_cmdline::rgb_command::vrml_header_wanted(path const &aPath)
+{
+DEBUG_METHOD_COUT
+    if (!rgb_fileio::is_vrml_header(aPath.string()))
+    {
+        skipped_header++;
+        return false;
+    }
+    return true;
+}
+
+string rgb_cmdline::rgb_command::display_name(rgb_param_pair const &aPair) const
+{
+DEBUG_METHOD_COUT
+    string aPath = aPair.path1.string();
+    if (!STRING_walk_root.empty())
+    {
+        // The walk builds its paths as root + "/" + relative path.
+        string prefix(STRING_walk_root);
+        while ((prefix.size() > 1) && (prefix[prefix.size() - 1] == '/')) {
+            prefix.erase(prefix.size() - 1);
+        }
+        if (prefix != "/") prefix += "/";
+        if (aPath.compare(0, prefix.size(), prefix) == 0) return aPath.substr(prefix.size());
+        return aPath;
+    }
+    if (!STRING_file_list.empty()) return aPath;
+    return aPair.path1.filename().string();
+}
+
+void rgb_cmdline::rgb_command::report()
+{
+DEBUG_METHOD_COUT
+    if ((skipped_extension > 0) || (skipped_header > 0))
+    {
+        cout << "Skipped : " << skipped_extension << " files without a \""
+             << CONST_STRING_VRML_FILE_EXTENTION << "\" extention, "
+             << skipped_header << " files without a \""
+             << CONST_STRING_VRML_HEADER << "\" header" << endl;
+    }
+
+    if (!STRING_walk_root.empty())
+    {
+        cout << "Walked : " << walker.directories << " directories";
+        if (walker.unreadable > 0) cout << ", " << walker.unreadable << " unreadable";
+        if (walker.links_skipped > 0) cout << ", " << walker.links_skipped << " links skipped";
+        if (walker.too_deep > 0) cout << ", " << walker.too_deep << " below -max-depth";
+        cout << endl;
+    }
+
+    if (!STRING_file_list.empty())
+    {
+        cout << "Listed : " << file_list.records << " files";
+        if (file_list.missing > 0) cout << ", " << file_list.missing << " not found";
+        cout << endl;
+    }
+}
+
 void rgb_cmdline::rgb_command::first_path_must_exist_second_may_not_exist(
     string const &p1, string const &p2)
 {
@@ -349,6 +937,12 @@ DEBUG_METHOD_COUT
 
     // NOTE we will only be using p2 if there was only a file input for p1
     //  This will be only in the case of the extract.
+    if ((!STRING_file_list.empty()) && (!p2.empty()))
+    {
+        aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+            "\"" + p2 + "\" cannot be used with -files-from.  Give a config on the line of each file instead.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
 
     path path2(p2);
     if (exists(path2) && is_directory(path2))
@@ -364,7 +958,7 @@ DEBUG_METHOD_COUT
     {
         // Only one file for p1 found ... go ahead and push 
         //  both parameters into the file pair vector
-        rgb_param_pair temp(p1,p2);
+        rgb_param_pair temp(file_paths[0],p2);
         input_file_pairs.push_back(temp);
     }
     else if (file_paths.size() > 1)
@@ -380,19 +974,52 @@ DEBUG_METHOD_COUT
     }
 }
 
-void rgb_cmdline::rgb_command::both_paths_must_exist(string const &p1, string const &p2)
+void rgb_cmdline::rgb_command::first_file_must_exist_second_may_not_exist(
+    string const &p1, string const &p2)
 {
 DEBUG_METHOD_COUT
-    // Get the file listing from the first parameter
-    vector<path> file_paths;
-    first_path_must_exist(p1, file_paths);
+    // The conversion commands take one config file, not a directory.
+    path path1(p1);
+    if (!exists(path1))
+    {
+        aLogger->throw_exception(ENUM_FILE_OR_DIRECTORY_NOT_FOUND,
+            "Parameter one: \"" + p1 + "\" does not exist.  Check the path or filename.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    if (!is_regular_file(path1))
+    {
+        aLogger->throw_exception(ENUM_UNKNOWN_FILE_TYPE,
+            "Parameter one: \"" + p1 + 
+            "\" is not a regular file.  Check the path or filename.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
 
-    // Verify the p2 exists and is a file.
     path path2(p2);
-    if (!exists(path2)) {
-        // P2 doesn't exist!  This is an error.
-        aLogger->throw_exception(ENUM_PARAM_TWO_NOT_FOUND,
-            "Parameter two: \"" + p2 + 
+    if (exists(path2) && is_directory(path2))
+    {
+        aLogger->throw_exception(ENUM_PARAM_TWO_IS_DIRECTORY,
+            "Parameter two: \"" + p2 + 
+            "\" cannot be a directory.  Check the path or filename.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    rgb_param_pair temp(path1, p2);
+    input_file_pairs.push_back(temp);
+}
+
+void rgb_cmdline::rgb_command::both_paths_must_exist(string const &p1, string const &p2)
+{
+DEBUG_METHOD_COUT
+    // Get the file listing from the first parameter
+    vector<path> file_paths;
+    first_path_must_exist(p1, file_paths);
+
+    // Verify the p2 exists and is a file.
+    path path2(p2);
+    if (!exists(path2)) {
+        // P2 doesn't exist!  This is an error.
+        aLogger->throw_exception(ENUM_PARAM_TWO_NOT_FOUND,
+            "Parameter two: \"" + p2 + 
             "\" does not exist.  Check the path or filename.",
             __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
     } else if (!is_regular_file(path2)) {
@@ -403,6 +1030,7 @@ DEBUG_METHOD_COUT
     }
 
     // P2 exists and is a regular file.  Push p1 an p2 into the file pair vector.
+    STRING_walk_config = p2;
     rgb_param_pair temp;
     for(path ii : file_paths) {
         // Place p1 in the file pair vector.
@@ -415,11 +1043,36 @@ DEBUG_METHOD_COUT
 void rgb_cmdline::rgb_command_extract::process()
 {
 DEBUG_METHOD_COUT
-    // Process each file
-    rgb_extract anExtractObj;
-    for(rgb_param_pair ii : input_file_pairs ) {
+    // Process each file.  Each worker has its own extractor.
+    unsigned int workers = worker_count();
+    unique_ptr<rgb_extract[]> extractors(new rgb_extract[workers]);
+    for (unsigned int ww = 0; ww < workers; ww++) {
+        extractors[ww].set_timestamp(config_timestamp);
+        extractors[ww].set_palette(config_palette);
+    }
+    rgb_cache aCache;
+    cache_open(aCache, extractors[0]);
+    for (unsigned int ww = 1; (ww < workers) && !STRING_cache_file.empty(); ww++) {
+        extractors[ww].set_cache(&aCache);
+    }
+
+    // Configs already in an existing bundle are kept unless extracted again.
+    rgb_bundle aBundle;
+    mutex bundle_mutex;
+    if ((!STRING_bundle_file.empty()) && exists(path(STRING_bundle_file)))
+    {
+        if (!rgb_bundle::is_bundle_file(STRING_bundle_file))
+        {
+            aLogger->throw_exception(ENUM_INVALID_BUNDLE_FILE,
+                "\"" + STRING_bundle_file + "\" exists and is not a bundle.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        aBundle.open(STRING_bundle_file);
+    }
+
+    for_each_pair([&](rgb_param_pair const &ii, ostream &out, unsigned int worker) {
 
-        cout << "Extract : " << ii.path1.filename().string() << " " << ii.path2;
+        out << "Extract : " << display_name(ii) << " " << ii.path2;
 
         try
         {
@@ -428,7 +1081,52 @@ DEBUG_METHOD_COUT
 cout << endl << endl << "P1 : " << canonical(ii.path1).string() << endl;
 cout << "P2 : " << ii.string1 << endl;
 #endif
-            anExtractObj.extract(canonical(ii.path1).string(), ii.path2);
+            if (STRING_bundle_file.empty())
+            {
+                extractors[worker].extract(canonical(ii.path1).string(), ii.path2);
+            }
+            else
+            {
+                string aNodeConfig;
+                string source_file = canonical(ii.path1).string();
+                extractors[worker].extract_config(source_file, aNodeConfig);
+                lock_guard<mutex> lock(bundle_mutex);
+                aBundle.add(source_file, aNodeConfig);
+            }
+            out << " - SUCCESS" << endl;
+        }
+        catch (ErrException& e)
+        {
+            out << " - " << e.what() << endl;
+        }
+        catch(const filesystem_error& e)
+        {
+            out << " - " << e.what() << endl;
+        }
+    });
+
+    if (!STRING_bundle_file.empty())
+    {
+        aBundle.write(STRING_bundle_file);
+        cout << "Bundle : " << STRING_bundle_file << " - " << aBundle.size()
+            << " configs" << endl;
+    }
+
+    cache_close(aCache);
+}
+
+void rgb_cmdline::rgb_command_export::process()
+{
+DEBUG_METHOD_COUT
+    // Process each file
+    rgb_extract anExtractObj;
+    for(rgb_param_pair ii : input_file_pairs ) {
+
+        cout << "Export : " << display_name(ii) << " " << ii.path2;
+
+        try
+        {
+            anExtractObj.extract_binary(canonical(ii.path1).string(), ii.path2);
             cout << " - SUCCESS" << endl;
         }
         catch (ErrException& e)
@@ -442,24 +1140,142 @@ cout << "P2 : " << ii.string1 << endl;
     }
 }
 
+void rgb_cmdline::rgb_command_to_binary::process()
+{
+DEBUG_METHOD_COUT
+    rgb_configio aConfigObj;
+    for(rgb_param_pair ii : input_file_pairs ) {
+
+        cout << "To binary : " << display_name(ii) << " " << ii.path2;
+
+        try
+        {
+            aConfigObj.convert_to_binary(ii.path1.string(), ii.path2);
+            cout << " - SUCCESS" << endl;
+        }
+        catch (ErrException& e)
+        {
+            cout << " - " << e.what() << endl;
+        }
+    }
+}
+
+void rgb_cmdline::rgb_command_to_text::process()
+{
+DEBUG_METHOD_COUT
+    rgb_configio aConfigObj;
+    aConfigObj.set_timestamp(config_timestamp);
+    aConfigObj.set_palette(config_palette);
+    for(rgb_param_pair ii : input_file_pairs ) {
+
+        cout << "To text : " << display_name(ii) << " " << ii.path2;
+
+        try
+        {
+            aConfigObj.convert_to_text(ii.path1.string(), ii.path2);
+            cout << " - SUCCESS" << endl;
+        }
+        catch (ErrException& e)
+        {
+            cout << " - " << e.what() << endl;
+        }
+    }
+}
+
 void rgb_cmdline::rgb_command_verify::process()
 {
 DEBUG_METHOD_COUT
-    // Verify
-    rgb_extract anExtractObj;
-    for(rgb_param_pair ii : input_file_pairs) {
+    // Verify.  Each worker has its own extractor.
+    unsigned int workers = worker_count();
+    unique_ptr<rgb_extract[]> extractors(new rgb_extract[workers]);
+    for (unsigned int ww = 0; ww < workers; ww++) {
+        extractors[ww].set_compare(comparator);
+    }
+    rgb_cache aCache;
+    cache_open(aCache, extractors[0]);
+    for (unsigned int ww = 1; (ww < workers) && !STRING_cache_file.empty(); ww++) {
+        extractors[ww].set_cache(&aCache);
+    }
+
+    // Each config is parsed once, however many files use it.
+    rgb_config_cache configs;
+    for_each_pair([&](rgb_param_pair const &ii, ostream &out, unsigned int worker) {
 
-        cout << "Verify : " << ii.path1.filename().string() << " " << ii.path2;
+        out << "Verify : " << display_name(ii) << " " << ii.path2;
         try
         {
 #if 0
 cout << endl << endl << "P1 : " << canonical(ii.path1).string() << endl;
 cout << "P2 : " << ii.string1 << endl;
 #endif
-            if (anExtractObj.verify(canonical(ii.path1).string(), ii.path2)) {
-                cout << " - MATCH" << endl;
+            rgb_node_table_ptr config_table = configs.get(ii.path2,
+                canonical(ii.path1).string());
+            vector<unsigned int> mismatches;
+            if (extractors[worker].verify(canonical(ii.path1).string(), *config_table,
+                    mismatches, verify_mode)) {
+                out << " - MATCH" << endl;
+            } else if (verify_mode == ENUM_VERIFY_FULL) {
+                out << " - no match (nodes";
+                for (unsigned int jj = 0; jj < mismatches.size(); jj++) {
+                    out << " " << mismatches[jj];
+                }
+                out << ")" << endl;
             } else {
-                cout << " - no match" << endl;
+                out << " - no match" << endl;
+            }
+        }
+        catch (ErrException& e)
+        {
+            out << " - " << e.what() << endl;
+        }
+        catch(const filesystem_error& e)
+        {
+            out << " - " << e.what() << endl;
+        }
+    });
+
+    cache_close(aCache);
+}
+
+void rgb_cmdline::rgb_command_diff::process()
+{
+DEBUG_METHOD_COUT
+    // Diff
+    rgb_diff aDiffObj;
+    aDiffObj.set_mode(diff_mode);
+    aDiffObj.set_format(diff_format);
+    aDiffObj.set_compare(comparator);
+
+    // Each config is parsed once, however many files use it.
+    rgb_config_cache configs;
+    for(rgb_param_pair ii : input_file_pairs) {
+
+        // The machine readable records go to stdout on their own so they
+        //  can be piped.  The file name is in every record.
+        if (diff_format == ENUM_DIFF_TEXT) {
+            cout << "Diff : " << display_name(ii) << " " << ii.path2 << endl;
+        }
+        try
+        {
+            bool same;
+            if (rgb_fileio::is_vrml_header(ii.path2)) {
+                // Two VRML files.  Both are streamed.
+                same = aDiffObj.diff_files(canonical(ii.path1).string(),
+                    canonical(path(ii.path2)).string(), cout);
+            } else {
+                rgb_node_table_ptr config_table = configs.get(ii.path2,
+                    canonical(ii.path1).string());
+                same = aDiffObj.diff(canonical(ii.path1).string(), *config_table, cout);
+            }
+            if (diff_format == ENUM_DIFF_TEXT) {
+                if (same) {
+                    cout << "  MATCH (" << aDiffObj.matched << " nodes)" << endl;
+                } else {
+                    cout << "  " << aDiffObj.matched << " same, "
+                         << aDiffObj.changed << " changed, "
+                         << aDiffObj.added << " added, "
+                         << aDiffObj.removed << " removed" << endl;
+                }
             }
         }
         catch (ErrException& e)
@@ -476,19 +1292,219 @@ cout << "P2 : " << ii.string1 << endl;
 void rgb_cmdline::rgb_command_replace::process()
 {
 DEBUG_METHOD_COUT
-    // Replace
-    rgb_replace aReplaceObj;
-    for(rgb_param_pair ii : input_file_pairs ) {
+    // Replace.  Each worker has its own replacer.
+    unsigned int workers = worker_count();
+    unique_ptr<rgb_replace[]> replacers(new rgb_replace[workers]);
+    for (unsigned int ww = 0; ww < workers; ww++) {
+        replacers[ww].set_keyed(keyed);
+        replacers[ww].set_timestamp(config_timestamp);
+        replacers[ww].set_dry_run(dry_run);
+        if (!transform.empty()) {
+            replacers[ww].set_transform(&transform);
+        }
+        if (!remap.empty()) {
+            replacers[ww].set_remap(&remap);
+        }
+    }
 
-        cout << "Replace : " << ii.path1.filename().string() << " " << ii.path2;
+    // Each config is parsed once, however many files use it, and each
+    //  plan is compiled once and shared by the workers.  Bundle entries
+    //  are not shared, so neither are their plans.
+    rgb_config_cache configs;
+    map<const rgb_node_table *, shared_ptr<const rgb_plan> > plans;
+    mutex plan_mutex;
+    atomic<unsigned int> planned(0);
+
+    // With -incremental a file is skipped when the manifest has it with
+    //  the same config and settings and it has not changed since.  Each
+    //  config is hashed once.
+    rgb_manifest aManifest;
+    map<string, uint64_t> config_hashes;
+    mutex config_hash_mutex;
+    uint64_t settings = 0;
+    if (!STRING_manifest_file.empty())
+    {
+        aManifest.open(STRING_manifest_file);
+        settings = settings_hash();
+    }
+    auto config_hash = [&](string const &aConfig, uint64_t &hash_value) {
+        {
+            lock_guard<mutex> lock(config_hash_mutex);
+            map<string, uint64_t>::const_iterator it = config_hashes.find(aConfig);
+            if (it != config_hashes.end())
+            {
+                hash_value = it->second;
+                return true;
+            }
+        }
+        try {
+            uint64_t file_size;
+            rgb_hash aHash(settings);
+            aHash.hash_file(aConfig, hash_value, file_size);
+        } catch (ErrException &) {
+            // Left to the replace to report.
+            return false;
+        }
+        lock_guard<mutex> lock(config_hash_mutex);
+        config_hashes[aConfig] = hash_value;
+        return true;
+    };
+
+    for_each_pair([&](rgb_param_pair const &ii, ostream &out, unsigned int worker) {
+
+        rgb_replace &aReplaceObj = replacers[worker];
+        shared_ptr<const rgb_plan> aPlan;
+
+        // Unchanged files print nothing.  Only the files replaced or
+        //  already matching are recorded, so a failed file is tried again.
+        string manifest_key;
+        uint64_t aConfigHash = 0;
+        bool recording = false;
+        if (!STRING_manifest_file.empty() && config_hash(ii.path2, aConfigHash))
+        {
+            manifest_key = absolute(ii.path1).string();
+            if (aManifest.is_unchanged(manifest_key, aConfigHash)) return;
+            recording = !dry_run;
+        }
+
+        out << "Replace : " << display_name(ii) << " " << ii.path2;
         try
         {
 #if 0
 cout << endl << endl << "P1 : " << canonical(ii.path1).string() << endl;
 cout << "P2 : " << ii.path2 << endl;
 #endif
-            aReplaceObj.replace(canonical(ii.path1).string(), ii.path2);
-            cout << " - SUCCESS" << endl;
+            rgb_node_table_ptr config_table = configs.get(ii.path2,
+                canonical(ii.path1).string());
+
+            auto compile_plan = [&]() {
+                shared_ptr<rgb_plan> temp(new rgb_plan);
+                temp->set_timestamp(config_timestamp);
+                temp->compile(*config_table, ii.path2,
+                    transform.empty() ? NULL : &transform,
+                    remap.empty() ? NULL : &remap, keyed);
+                return shared_ptr<const rgb_plan>(temp);
+            };
+
+            if (use_plan && configs.is_bundle(ii.path2))
+            {
+                // A bundle entry is used by this file only.
+                aPlan = compile_plan();
+            }
+            else if (use_plan)
+            {
+                lock_guard<mutex> lock(plan_mutex);
+                shared_ptr<const rgb_plan> &compiled = plans[config_table.get()];
+                if (!compiled)
+                {
+                    compiled = compile_plan();
+                }
+                aPlan = compiled;
+            }
+
+            // A huge file is scanned in chunks by the workers left idle.
+            vector<rgb_patch> patches;
+            if (aPlan && aPlan->apply(canonical(ii.path1).string(), patches,
+                    dry_run, 1 + spare_workers()))
+            {
+                // Same layout as the config: patched from the plan.
+                planned++;
+                if (dry_run) {
+                    print_plan(out, patches);
+                } else {
+                    out << " - SUCCESS (plan)" << endl;
+                }
+                if (recording) aManifest.record(manifest_key, aConfigHash);
+                return;
+            }
+
+            aReplaceObj.replace(canonical(ii.path1).string(), *config_table, ii.path2);
+            if (dry_run) {
+                print_plan(out, aReplaceObj.plan);
+            } else {
+                out << " - SUCCESS" << endl;
+            }
+            print_unmatched(out, "Not in config", aReplaceObj.unmatched_source);
+            print_unmatched(out, "Not in file", aReplaceObj.unmatched_config);
+            if (recording) aManifest.record(manifest_key, aConfigHash);
+        }
+        catch (ErrException& e)
+        {
+            out << " - " << e.what() << endl;
+
+            // Already replaced: nothing to do next time either.
+            if (recording && (e.error() == ENUM_RGB_NODES_MATCH)) {
+                aManifest.record(manifest_key, aConfigHash);
+            }
+        }
+        catch(const filesystem_error& e)
+        {
+            out << " - " << e.what() << endl;
+        }
+    });
+
+    if (use_plan) {
+        cout << "Plan : " << planned << " of " << (files_processed - aManifest.unchanged)
+             << " files matched the compiled plan" << endl;
+    }
+    if (!STRING_manifest_file.empty())
+    {
+        if (!dry_run) aManifest.save();
+        aManifest.print_statistics(cout);
+    }
+}
+
+uint64_t rgb_cmdline::rgb_command_replace::settings_hash()
+{
+DEBUG_METHOD_COUT
+    // The transform expression, the remap palette and -keyed.  The
+    //  timestamp only changes the history config, not the colors.
+    rgb_hash aHash;
+    string settings = string(keyed ? "keyed" : "") + "\n" + STRING_transform + "\n";
+    aHash.update(settings.data(), settings.size());
+    if (!STRING_remap_file.empty())
+    {
+        uint64_t remap_hash;
+        uint64_t remap_size;
+        rgb_hash aRemapHash;
+        aRemapHash.hash_file(STRING_remap_file, remap_hash, remap_size);
+        aHash.update(&remap_hash, sizeof(remap_hash));
+    }
+    return aHash.digest();
+}
+
+void rgb_cmdline::rgb_command_replace::print_unmatched(ostream &out,
+    string const &aLabel, vector<string> const &names)
+{
+DEBUG_METHOD_COUT
+    if (names.empty()) return;
+
+    out << "  " << aLabel << " (" << names.size() << ") :";
+    for (unsigned int ii = 0; ii < names.size(); ii++) {
+        out << " " << names[ii];
+    }
+    out << endl;
+}
+
+void rgb_cmdline::rgb_command_transform::process()
+{
+DEBUG_METHOD_COUT
+    // Transform
+    rgb_replace aReplaceObj;
+    aReplaceObj.set_timestamp(config_timestamp);
+    aReplaceObj.set_dry_run(dry_run);
+    for(rgb_param_pair ii : input_file_pairs) {
+
+        cout << "Transform : " << display_name(ii);
+        try
+        {
+            aReplaceObj.recolor(canonical(ii.path1).string(), &transform,
+                remap.empty() ? NULL : &remap);
+            if (dry_run) {
+                print_plan(cout, aReplaceObj.plan);
+            } else {
+                cout << " - SUCCESS" << endl;
+            }
         }
         catch (ErrException& e)
         {
@@ -501,20 +1517,47 @@ cout << "P2 : " << ii.path2 << endl;
     }
 }
 
-void rgb_cmdline::rgb_command_rollback::process()
+void rgb_cmdline::rgb_command_remap::process()
 {
 DEBUG_METHOD_COUT
-    // Replace
-    rgb_rollback aRollbackObj;
+    // Remap
+    rgb_replace aReplaceObj;
+    aReplaceObj.set_timestamp(config_timestamp);
+    aReplaceObj.set_dry_run(dry_run);
     for(rgb_param_pair ii : input_file_pairs) {
 
-        cout << "Rollback : " << ii.path1.filename().string();
+        cout << "Remap : " << display_name(ii) << " " << ii.path2;
         try
         {
-#if 0
-cout << endl << endl << "P1 : " << canonical(ii.path1).string() << endl;
-#endif
-            aRollbackObj.rollback(canonical(ii.path1).string());
+            aReplaceObj.recolor(canonical(ii.path1).string(), NULL, &remap);
+            if (dry_run) {
+                print_plan(cout, aReplaceObj.plan);
+            } else {
+                cout << " - SUCCESS" << endl;
+            }
+        }
+        catch (ErrException& e)
+        {
+            cout << " - " << e.what() << endl;
+        }
+        catch(const filesystem_error& e)
+        {
+            cout << " - " << e.what() << endl;
+        }
+    }
+}
+
+void rgb_cmdline::rgb_command_reduce::process()
+{
+DEBUG_METHOD_COUT
+    // Read the colors of every file, then reduce them once.
+    rgb_reduce aReduceObj;
+    for(rgb_param_pair ii : input_file_pairs) {
+
+        cout << "Read : " << display_name(ii);
+        try
+        {
+            aReduceObj.add_file(canonical(ii.path1).string());
             cout << " - SUCCESS" << endl;
         }
         catch (ErrException& e)
@@ -526,6 +1569,107 @@ cout << endl << endl << "P1 : " << canonical(ii.path1).string() << endl;
             cout << " - " << e.what() << endl;
         }
     }
+
+    cout << "Reduce : " << aReduceObj.colors_added() << " nodes, "
+         << aReduceObj.distinct_colors() << " distinct colors";
+    try
+    {
+        vector<rgb_node> palette;
+        aReduceObj.reduce(palette_colors, palette);
+
+        rgb_configio aConfigObj;
+        aConfigObj.set_timestamp(config_timestamp);
+        aConfigObj.write_node_config_file(palette, STRING_param_one, STRING_param_two);
+        cout << " -> " << palette.size() << " colors in " << aReduceObj.iterations
+             << " steps - SUCCESS" << endl;
+    }
+    catch (ErrException& e)
+    {
+        cout << " - " << e.what() << endl;
+    }
+}
+
+void rgb_cmdline::rgb_command_fanout::process()
+{
+DEBUG_METHOD_COUT
+    // The source is read once and every variant written from it.
+    path source(canonical(input_file_pairs[0].path1));
+    path output_directory = STRING_output_directory.empty() ?
+        source.parent_path() : path(STRING_output_directory);
+
+    rgb_fanout aFanoutObj;
+    aFanoutObj.set_keyed(keyed);
+    aFanoutObj.set_timestamp(config_timestamp);
+    try
+    {
+        if (!is_directory(output_directory))
+        {
+            aLogger->throw_exception(ENUM_FILE_OR_DIRECTORY_NOT_FOUND,
+                "Output directory \"" + output_directory.string() + "\" does not exist.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        aFanoutObj.open(source.string());
+    }
+    catch (ErrException& e)
+    {
+        cout << "Fanout : " << source.filename().string() << " - " << e.what() << endl;
+        return;
+    }
+
+    // "<source name>_<config name><source extension>"
+    rgb_config_cache configs;
+    for(rgb_param_pair ii : input_file_pairs) {
+        path config(ii.path2);
+        path output = output_directory / (source.stem().string() + "_" +
+            config.stem().string() + source.extension().string());
+        try
+        {
+            aFanoutObj.add(configs.get(ii.path2, source.string()), ii.path2, output.string());
+        }
+        catch (ErrException& e)
+        {
+            cout << "Fanout : " << config.filename().string() << " - " << e.what() << endl;
+        }
+    }
+
+    aFanoutObj.write();
+
+    for (rgb_variant const &aVariant : aFanoutObj.variants) {
+        cout << "Fanout : " << path(aVariant.output_file).filename().string()
+             << " " << aVariant.config_file;
+        if (aVariant.error.empty()) {
+            cout << " - SUCCESS (" << aVariant.changed << " changes)" << endl;
+        } else {
+            cout << " - " << aVariant.error << endl;
+        }
+    }
+}
+
+void rgb_cmdline::rgb_command_rollback::process()
+{
+DEBUG_METHOD_COUT
+    // Rollback.  Each worker has its own rollback object.
+    unique_ptr<rgb_rollback[]> rollbacks(new rgb_rollback[worker_count()]);
+    for_each_pair([&](rgb_param_pair const &ii, ostream &out, unsigned int worker) {
+
+        out << "Rollback : " << display_name(ii);
+        try
+        {
+#if 0
+cout << endl << endl << "P1 : " << canonical(ii.path1).string() << endl;
+#endif
+            rollbacks[worker].rollback(canonical(ii.path1).string());
+            out << " - SUCCESS" << endl;
+        }
+        catch (ErrException& e)
+        {
+            out << " - " << e.what() << endl;
+        }
+        catch(const filesystem_error& e)
+        {
+            out << " - " << e.what() << endl;
+        }
+    });
 }
 
 void rgb_cmdline::print_usage()
@@ -536,23 +1680,125 @@ cout << "  - Displays this usage information" << endl;
 cout << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -extract <single_file_or_directory> [optional_config_file]" << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -e <single_file_or_directory> [optional_config_file]" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -extract -files-from <file_list_or_->" << endl;
 cout << "  - Extracts RGB node information from a single VRML file or all the" << endl;
 cout << "     VRML files in a directory." << endl;
+cout << "     -cache <cache_file> : Skips parsing files whose content hash is in the cache." << endl;
+cout << "     -cache-size <MB> : Cache size limit.  Least recently used entries are evicted." << endl;
+cout << "     -no-timestamp : Leaves the \"created\" line out of the config." << endl;
+cout << "     -palette : Writes each distinct color once and a color number per node." << endl;
+cout << "     -bundle <bundle_file> : Writes every config into one bundle file instead." << endl;
+cout << "     -jobs <n> : Processes n files at a time, largest first (0 for one per" << endl;
+cout << "        core).  Output is printed in the same order as with one job." << endl;
+cout << "     -recursive : Processes the VRML files of every directory below the directory" << endl;
+cout << "        as they are found.  Files are printed in the order they were found." << endl;
+cout << "     -max-depth <n> : With -recursive, enters at most n directory levels." << endl;
+cout << "     -links <skip|files|follow> : With -recursive, ignores symbolic links (default)," << endl;
+cout << "        follows links to files only, or follows every link." << endl;
+cout << "     -files-from <file_list_or_-> : Processes the files listed, one per line or" << endl;
+cout << "        NUL separated, read from the file or standard input (\"-\") as the files" << endl;
+cout << "        are processed.  A line may give a config after a TAB." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -export <single_file_or_directory> [optional_binary_file]" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -x <single_file_or_directory> [optional_binary_file]" << endl;
+cout << "  - Extracts RGB node information into a binary node file with a name" << endl;
+cout << "     string table and little-endian float32 red, green and blue columns." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -to-binary <config_file> [optional_binary_file]" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -tb <config_file> [optional_binary_file]" << endl;
+cout << "  - Converts a text RGB config file into a binary node file.  Binary files" << endl;
+cout << "     can be given anywhere a config file is required." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -to-text <binary_file> [optional_config_file]" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -tt <binary_file> [optional_config_file]" << endl;
+cout << "  - Converts a binary node file back into an editable text RGB config file." << endl;
+cout << "     -no-timestamp and -palette : Same as -extract." << endl;
 cout << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -verify <single_file_or_directory> <required_config_file>" << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -v <single_file_or_directory> <required_config_file>" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -verify -files-from <file_list_or_-> <default_config_file>" << endl;
 cout << "  - Verifies that the RGB nodes in a single VRML or all the files in a directory" << endl;
-cout << "     match the ones found in a required RGB config file." << endl;
+cout << "     match the ones found in a required RGB config file.  Stops reading a file" << endl;
+cout << "     at its first mismatched node.  The config may be a bundle." << endl;
+cout << "     -full : Reads every file to the end and lists all mismatched node indices." << endl;
+cout << "     -tolerance <value> : Colors match if they differ by no more than <value>" << endl;
+cout << "        (e.g. 1e-6) or, written as <n>ulp, by no more than n float steps." << endl;
+cout << "     -cache <cache_file> and -cache-size <MB> : Same as -extract." << endl;
+cout << "     -jobs <n>, -recursive, -max-depth <n>, -links <policy> and -files-from" << endl;
+cout << "        <file_list_or_-> : Same as -extract." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -diff <single_file_or_directory> <required_config_or_VRML_file>" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -d <single_file_or_directory> <required_config_or_VRML_file>" << endl;
+cout << "  - Lists the RGB nodes that differ between a single VRML file or all the files" << endl;
+cout << "     in a directory and a required RGB config file or bundle.  Nodes are aligned" << endl;
+cout << "     by name with a shortest edit script, so added and removed nodes do not shift" << endl;
+cout << "     the rest of the file.  When the second file is a VRML file both files are" << endl;
+cout << "     streamed and aligned within a window of " << CONST_DIFF_WINDOW_SIZE << " nodes." << endl;
+cout << "     -by-name : Pairs nodes with the same DEF name wherever they are." << endl;
+cout << "     -by-position : Pairs nodes with the same index." << endl;
+cout << "     -machine : Prints one tab separated record per difference." << endl;
+cout << "     -tolerance <value> : Same as -verify." << endl;
 cout << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -replace <single_file_or_directory> <required_config_file>" << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -r <single_file_or_directory> <required_config_file>" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -replace -files-from <file_list_or_-> <default_config_file>" << endl;
 cout << "  - Replaces the RGB nodes in a single VRML file or all the VRML files found in " << endl;
-cout << "     a directory.  Requires a RGB config file." << endl;
+cout << "     a directory.  Requires a RGB config file or bundle." << endl;
+cout << "     -keyed : Matches config nodes to file nodes by DEF name instead of by" << endl;
+cout << "        position.  Names found on only one side are listed." << endl;
+cout << "     -transform <expression> : Transforms the config colors before they are written." << endl;
+cout << "     -remap <palette_config> : Snaps the config colors to the nearest palette color." << endl;
+cout << "     -dry-run : Lists the node, name, byte offset and old and new colors of every" << endl;
+cout << "        change without writing the file." << endl;
+cout << "     -plan : Compiles the config once and patches files with the same layout" << endl;
+cout << "        (node count and names) directly.  Other files are replaced as usual." << endl;
+cout << "        With -jobs, idle workers help scan a large file." << endl;
+cout << "     -no-timestamp : Leaves the \"created\" line out of the history config." << endl;
+cout << "     -incremental <manifest_file> : Skips files not changed since they were last" << endl;
+cout << "        replaced with the same config and options.  Checks size and mtime first." << endl;
+cout << "     -jobs <n>, -recursive, -max-depth <n>, -links <policy> and -files-from" << endl;
+cout << "        <file_list_or_-> : Same as -extract." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -transform <single_file_or_directory> <expression>" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -t <single_file_or_directory> <expression>" << endl;
+cout << "  - Transforms the RGB nodes in a single VRML file or all the VRML files found in" << endl;
+cout << "     a directory.  The expression is a comma separated list of hue=<degrees>," << endl;
+cout << "     saturation=<percent>, desaturate=<percent>, brightness=<factor> and" << endl;
+cout << "     gamma=<value>, applied in order (e.g. \"hue=+10,desaturate=30%,gamma=2.2\")." << endl;
+cout << "     Colors are clamped to [0,1] after every operator." << endl;
+cout << "     The change can be undone with -rollback." << endl;
+cout << "     -remap <palette_config> : Snaps the transformed colors to the palette." << endl;
+cout << "     -dry-run and -no-timestamp : Same as -replace." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -remap <single_file_or_directory> <palette_config>" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -m <single_file_or_directory> <palette_config>" << endl;
+cout << "  - Snaps every RGB node in a single VRML file or all the VRML files found in a" << endl;
+cout << "     directory to the nearest color (CIELAB delta E) of the palette config." << endl;
+cout << "     The change can be undone with -rollback." << endl;
+cout << "     -dry-run and -no-timestamp : Same as -replace." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -reduce <single_file_or_directory> <palette_config>" << endl;
+cout << "  - Reduces the colors of a single VRML file or all the VRML files found in a" << endl;
+cout << "     directory to a few representative colors with k-means and writes them as" << endl;
+cout << "     a palette config for -remap." << endl;
+cout << "     -colors <n> : Number of palette colors (default " << CONST_REDUCE_DEFAULT_COLORS << ")." << endl;
+cout << "     -no-timestamp : Same as -extract." << endl;
+cout << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -fanout <single_file> <config_file_or_directory>" << endl;
+cout << "  - Writes one copy of the VRML file per config (every file in the directory)," << endl;
+cout << "     named <file>_<config>.wrl, each with the colors of its config as if" << endl;
+cout << "     replaced.  The file is read once and the copies are written in parallel." << endl;
+cout << "     -out <directory> : Where the copies go.  Default: next to the file." << endl;
+cout << "     -keyed : Matches config nodes to file nodes by DEF name (see -replace)." << endl;
+cout << "     -no-timestamp : Same as -replace." << endl;
 cout << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -rollback <single_file_or_directory>" << endl;
 cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -roll <single_file_or_directory>" << endl;
+cout << CONST_STRING_DEFAULT_ARGUMENT_ZERO << " -rollback -files-from <file_list_or_->" << endl;
 cout << "  - Rollsback the RGB nodes previously changed from the \"-replace\" command." << endl;
 cout << "     Requires a single VRML file or all the VMRL files found in a directory." << endl; 
+cout << "     -jobs <n>, -recursive, -max-depth <n>, -links <policy> and -files-from" << endl;
+cout << "        <file_list_or_-> : Same as -extract." << endl;
 cout << endl;
 }
 
@@ -0,0 +1,162 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_compare.cpp
+##  This file defines the methods used to compare RGB color columns.  When
+##   SSE2 is available four colors are checked against the absolute tolerance
+##   at a time.  Only lanes that fail that check fall back to the ULP check.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_compare_h__
+#include "include/rgb_compare.h"
+#endif
+
+#include <cstring>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void rgb_compare::set_absolute_tolerance(float const &tolerance)
+{
+    if (!(tolerance >= 0.0))
+    {
+        aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+            "The absolute tolerance must be zero or greater.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    absolute_tolerance = tolerance;
+}
+
+void rgb_compare::set_ulp_tolerance(unsigned int const &tolerance)
+{
+    ulp_tolerance = tolerance;
+}
+
+bool rgb_compare::equal(float const &a, float const &b) const
+{
+    if (a == b) return true;
+
+    // NaN never matches.
+    if ((a != a) || (b != b)) return false;
+
+    if (((a > b) ? (a - b) : (b - a)) <= absolute_tolerance) return true;
+
+    if (ulp_tolerance == 0) return false;
+
+    // Map the float bits onto a line of integers where neighbouring
+    //  floats are one apart.
+    int32_t ia, ib;
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+    int64_t oa = (ia >= 0) ? (int64_t)ia : (int64_t)INT32_MIN - ia;
+    int64_t ob = (ib >= 0) ? (int64_t)ib : (int64_t)INT32_MIN - ib;
+    int64_t distance = (oa > ob) ? (oa - ob) : (ob - oa);
+
+    return distance <= (int64_t)ulp_tolerance;
+}
+
+bool rgb_compare::equal(rgb_node const &a, rgb_node const &b) const
+{
+    return equal(a.get_red(), b.get_red()) &&
+           equal(a.get_green(), b.get_green()) &&
+           equal(a.get_blue(), b.get_blue());
+}
+
+void rgb_compare::compare_column(const float *a, const float *b, size_t count,
+    unsigned char *result) const
+{
+    size_t ii = 0;
+
+#if defined(__SSE2__)
+    // Four lanes at a time.  The abs() is done by clearing the sign bit.
+    const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 tolerance = _mm_set1_ps(absolute_tolerance);
+    for (; ii + 4 <= count; ii += 4)
+    {
+        __m128 va = _mm_loadu_ps(a + ii);
+        __m128 vb = _mm_loadu_ps(b + ii);
+        __m128 diff = _mm_and_ps(_mm_sub_ps(va, vb), sign_mask);
+        int within = _mm_movemask_ps(_mm_cmple_ps(diff, tolerance));
+
+        if (within == 0xf) continue;
+
+        // At least one lane is outside the absolute tolerance.
+        for (size_t jj = ii; jj < ii + 4; jj++)
+        {
+            if (!(within & (1 << (jj - ii))) && !equal(a[jj], b[jj]))
+            {
+                result[jj] = 0;
+            }
+        }
+    }
+#endif
+
+    for (; ii < count; ii++)
+    {
+        if (!equal(a[ii], b[ii]))
+        {
+            result[ii] = 0;
+        }
+    }
+}
+
+bool rgb_compare::compare(rgb_node_columns const &a, size_t a_offset,
+    rgb_node_columns const &b, size_t b_offset,
+    size_t count,
+    vector<unsigned int> &mismatches,
+    bool stop_at_first) const
+{
+    if (count == 0) return true;
+
+    return compare(a, a_offset, &b.red[b_offset], &b.green[b_offset], &b.blue[b_offset],
+        count, mismatches, stop_at_first);
+}
+
+bool rgb_compare::compare(rgb_node_columns const &a, size_t a_offset,
+    const float *b_red, const float *b_green, const float *b_blue,
+    size_t count,
+    vector<unsigned int> &mismatches,
+    bool stop_at_first) const
+{
+    if (count == 0) return true;
+
+    vector<unsigned char> result(count, 1);
+    compare_column(&a.red[a_offset], b_red, count, &result[0]);
+    compare_column(&a.green[a_offset], b_green, count, &result[0]);
+    compare_column(&a.blue[a_offset], b_blue, count, &result[0]);
+
+    bool matched = true;
+    for (size_t ii = 0; ii < count; ii++)
+    {
+        if (!result[ii])
+        {
+            matched = false;
+            mismatches.push_back(a_offset + ii);
+            if (stop_at_first) break;
+        }
+    }
+    return matched;
+}
@@ -0,0 +1,236 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_config_lexer.cpp
+##  This file defines the methods of the RGB config tokenizer.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_config_lexer_h__
+#include "include/rgb_config_lexer.h"
+#endif
+
+#include <cstdlib>
+#include <stdint.h>
+
+static bool is_space(char aChar)
+{
+    return (aChar == ' ') || (aChar == '\n') || (aChar == '\t') ||
+        (aChar == '\r') || (aChar == '\v') || (aChar == '\f');
+}
+
+static bool is_digit(char aChar)
+{
+    return (aChar >= '0') && (aChar <= '9');
+}
+
+// Powers of ten that are exact in a double.
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+void rgb_config_lexer::open(const char *data, size_t size, string const &aSourceName)
+{
+    buffer_end = data + size;
+    position = data;
+    line_start = data;
+    line_number = 1;
+    source_name = aSourceName;
+}
+
+bool rgb_config_lexer::next(rgb_config_token &aToken)
+{
+    // Skip whitespace, counting lines.
+    while ((position < buffer_end) && is_space(*position))
+    {
+        if (*position == '\n')
+        {
+            line_number++;
+            line_start = position + 1;
+        }
+        position++;
+    }
+
+    if (position >= buffer_end) return false;
+
+    aToken.text = position;
+    aToken.line = line_number;
+    aToken.column = (position - line_start) + 1;
+
+    while ((position < buffer_end) && !is_space(*position)) position++;
+
+    aToken.size = position - aToken.text;
+    return true;
+}
+
+void rgb_config_lexer::skip_line()
+{
+    while ((position < buffer_end) && (*position != '\n')) position++;
+}
+
+unsigned long rgb_config_lexer::to_count(rgb_config_token const &aToken)
+{
+    // Digits only.  Anything larger than the buffer could hold is corrupt.
+    unsigned long count = 0;
+    bool valid = (aToken.size > 0) && (aToken.size <= 18);
+    for (size_t ii = 0; valid && (ii < aToken.size); ii++)
+    {
+        if (!is_digit(aToken.text[ii])) valid = false;
+        else count = (count * 10) + (aToken.text[ii] - '0');
+    }
+
+    if (!valid)
+    {
+        error(aToken, "expected a node count but found \"" + aToken.str() + "\"");
+    }
+    return count;
+}
+
+float rgb_config_lexer::to_color(rgb_config_token const &aToken)
+{
+    double value;
+    if (!parse_number(aToken.text, aToken.size, value))
+    {
+        error(aToken, "expected a color value but found \"" + aToken.str() + "\"");
+    }
+
+    // Written this way round so a NaN is rejected too.
+    if (!((value >= CONST_RGB_COLOR_VALUE_MIN) && (value <= CONST_RGB_COLOR_VALUE_MAX)))
+    {
+        stringstream anError;
+        anError << "color value " << aToken.str() << " is outside "
+            << CONST_RGB_COLOR_VALUE_MIN << " to " << CONST_RGB_COLOR_VALUE_MAX;
+        error(aToken, anError.str());
+    }
+    return value;
+}
+
+void rgb_config_lexer::error(rgb_config_token const &aToken, string const &aMessage)
+{
+    stringstream anError;
+    anError << "Config " << source_name << " line " << aToken.line
+        << ", column " << aToken.column << ": " << aMessage << ".";
+    aLogger->throw_exception(ENUM_CONFIG_PARSE_ERROR, anError.str(),
+        __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+}
+
+void rgb_config_lexer::error_at_end(string const &aMessage)
+{
+    rgb_config_token end_token;
+    end_token.line = line_number;
+    end_token.column = (position - line_start) + 1;
+    error(end_token, aMessage);
+}
+
+bool rgb_config_lexer::parse_number(const char *text, size_t size, double &value)
+{
+    const char *p = text;
+    const char *end = text + size;
+
+    // [+-]digits[.digits][(e|E)[+-]digits]
+    bool negative = false;
+    if ((p < end) && ((*p == '+') || (*p == '-')))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;       // significant digits kept in the mantissa
+    int exponent = 0;
+    bool any_digits = false;
+    bool too_long = false;
+
+    for (; (p < end) && is_digit(*p); p++)
+    {
+        any_digits = true;
+        if ((mantissa == 0) && (*p == '0')) continue;
+        if (digits < 19) {
+            mantissa = (mantissa * 10) + (*p - '0');
+            digits++;
+        } else {
+            too_long = true;
+        }
+    }
+
+    if ((p < end) && (*p == '.'))
+    {
+        p++;
+        for (; (p < end) && is_digit(*p); p++)
+        {
+            any_digits = true;
+            if ((mantissa == 0) && (*p == '0')) {
+                exponent--;
+                continue;
+            }
+            if (digits < 19) {
+                mantissa = (mantissa * 10) + (*p - '0');
+                digits++;
+                exponent--;
+            } else {
+                too_long = true;
+            }
+        }
+    }
+
+    if (!any_digits) return false;
+
+    if ((p < end) && ((*p == 'e') || (*p == 'E')))
+    {
+        p++;
+        bool exponent_negative = false;
+        if ((p < end) && ((*p == '+') || (*p == '-')))
+        {
+            exponent_negative = (*p == '-');
+            p++;
+        }
+        if ((p >= end) || !is_digit(*p)) return false;
+
+        int written = 0;
+        for (; (p < end) && is_digit(*p); p++)
+        {
+            if (written < 10000) written = (written * 10) + (*p - '0');
+        }
+        exponent += exponent_negative ? -written : written;
+    }
+
+    if (p != end) return false;
+
+    // A mantissa below 2^53 and a power of ten up to 1e22 are both exact,
+    //  so one multiply or divide gives the correctly rounded result.
+    if (!too_long && (mantissa < ((uint64_t)1 << 53)) &&
+        (exponent >= -22) && (exponent <= 22))
+    {
+        value = (double)mantissa;
+        if (exponent < 0) value /= exact_powers_of_ten[-exponent];
+        else value *= exact_powers_of_ten[exponent];
+        if (negative) value = -value;
+        return true;
+    }
+
+    // Long or extreme values.  The text is already known to be a number.
+    string number(text, size);
+    value = strtod(number.c_str(), NULL);
+    return true;
+}
@@ -30,74 +30,302 @@
 #include "include/rgb_configio.h"
 #endif
 
-#if 0
-#define DEBUG_BLAH cout << __PRETTY_FUNCTION__ << aWord << endl;
-#else
-#define DEBUG_BLAH //
+#ifndef __rgb_binaryio_h__
+#include "include/rgb_binaryio.h"
 #endif
 
+#ifndef __rgb_hash_h__
+#include "include/rgb_hash.h"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+
 
 void rgb_configio::parse_node_config(string const &aNodeConfig,
     vector<rgb_node> &node_vector) 
 {
     // Determine if the aNodeConfig is a long string that contains the
     //  RGB config information or a filename which can be opened
-    stringstream inputSS(aNodeConfig);
-    string aWord;
-
-    // Grab one word from the input string
-    inputSS >> aWord;
-
-    if (aWord == CONST_STRING_CONFIG_START_KEYWORD)
+    size_t first = aNodeConfig.find_first_not_of(" \t\n\r\v\f");
+    if ((first != string::npos) &&
+        (aNodeConfig.compare(first, CONST_STRING_CONFIG_START_KEYWORD.size(),
+            CONST_STRING_CONFIG_START_KEYWORD) == 0))
     {
         // First word is the #START keyword.  This is a string containing
         //  a RGB node config.
+        parse_node_config_buffer(aNodeConfig.data(), aNodeConfig.size(),
+            "string", node_vector);
+        return;
+    }
+
+    if (rgb_binaryio::is_binary_file(aNodeConfig))
+    {
+        // Binary config.  Map it and copy the nodes out.
+        rgb_binary_view view;
+        view.open(aNodeConfig);
+        view.to_nodes(node_vector);
+        return;
+    }
+
+    // Attempt to open it as a filename and read it in one go.
+    ifstream node_config_file(aNodeConfig.c_str(), ios::in | ios::binary);
 
-        // Send this first word to the state machine.
-        process(aWord);
+    if (!node_config_file)
+    {
+        // Unable to open the config file for reading....
+        //  This is an error.
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
+            "Unable to open node config for reading.  Check the input config file.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    node_config_file.seekg(0, ios::end);
+    streamoff size = node_config_file.tellg();
+    node_config_file.seekg(0, ios::beg);
+    if (size < 0) size = 0;
+
+    vector<char> buffer(size);
+    if (size > 0) node_config_file.read(&buffer[0], size);
+    if (!node_config_file)
+    {
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
+            "Unable to read node config \"" + aNodeConfig + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    parse_node_config_buffer(buffer.empty() ? NULL : &buffer[0], buffer.size(),
+        "\"" + aNodeConfig + "\"", node_vector);
+}
 
-        // Process the rest of the string
-        while (inputSS >> aWord)
+void rgb_configio::parse_node_config_buffer(const char *data, size_t size,
+    string const &aSourceName,
+    vector<rgb_node> &node_vector)
+{
+    // Config layout:
+    // #START V001
+    // #COMMENT ... (to the end of the line)
+    // #NUM_NODES __NUMBER_OF_NODES__
+    // #NODE node_name RED GREEN BLUE
+    // #END
+    // or the palette layout:
+    // #START V002
+    // #NUM_COLORS __NUMBER_OF_COLORS__
+    // #COLOR RED GREEN BLUE          (numbered from 0 in order)
+    // #NUM_NODES __NUMBER_OF_NODES__
+    // #NODE node_name COLOR_NUMBER
+    // #END
+    // Other words before #NUM_NODES and between the nodes are skipped.
+    node_vector.clear();
+    parse_palette = false;
+
+    rgb_config_lexer lexer;
+    lexer.open(data, size, aSourceName);
+    rgb_config_token token;
+
+    if (!lexer.next(token) || !token.is(CONST_STRING_CONFIG_START_KEYWORD))
+    {
+        if (token.text) lexer.error(token, "expected \"" + CONST_STRING_CONFIG_START_KEYWORD
+            + "\" but found \"" + token.str() + "\"");
+        lexer.error_at_end("expected \"" + CONST_STRING_CONFIG_START_KEYWORD + "\"");
+    }
+
+    if (!lexer.next(token)) lexer.error_at_end("missing config version");
+    if (token.is(CONST_STRING_CONFIG_PALETTE_VERSION))
+    {
+        parse_palette = true;
+    }
+    else if (!token.is(CONST_STRING_CONFIG_CURRENT_VERSION))
+    {
+        lexer.error(token, "unsupported config version \"" + token.str() + "\"");
+    }
+
+    // Read the palette.  It ends at the node count.
+    vector<rgb_node> palette;
+    rgb_config_token colors_token;
+    unsigned long expected_colors = 0;
+    bool found = false;
+    while (parse_palette && !found && lexer.next(token))
+    {
+        if (token.is(CONST_STRING_CONFIG_COMMENT_KEYWORD))
         {
-            process(aWord);
+            lexer.skip_line();
         }
-    } 
-    else // Attempt to open it as a filename.
+        else if (token.is(CONST_STRING_CONFIG_NUM_COLORS_KEYWORD))
+        {
+            if (!lexer.next(colors_token)) lexer.error_at_end("missing color count");
+            expected_colors = lexer.to_count(colors_token);
+            palette.reserve((expected_colors < size / 14) ? expected_colors : size / 14);
+        }
+        else if (token.is(CONST_STRING_CONFIG_COLOR_KEYWORD))
+        {
+            // #COLOR <R> <G> <B>
+            rgb_config_token red, green, blue;
+            if (!lexer.next(red) || !lexer.next(green) || !lexer.next(blue))
+            {
+                lexer.error(token, "incomplete \"" + CONST_STRING_CONFIG_COLOR_KEYWORD + "\"");
+            }
+
+            rgb_node temp_color;
+            temp_color.set_red(lexer.to_color(red));
+            temp_color.set_green(lexer.to_color(green));
+            temp_color.set_blue(lexer.to_color(blue));
+            palette.push_back(temp_color);
+        }
+        else if (token.is(CONST_STRING_CONFIG_NUM_NODES_KEYWORD))
+        {
+            found = true;
+        }
+    }
+    if (parse_palette)
+    {
+        if (!colors_token.text)
+        {
+            lexer.error_at_end("missing \"" + CONST_STRING_CONFIG_NUM_COLORS_KEYWORD + "\"");
+        }
+        if (palette.size() != expected_colors)
+        {
+            stringstream anError;
+            anError << CONST_STRING_CONFIG_NUM_COLORS_KEYWORD << " " << expected_colors
+                << " does not match the " << palette.size() << " colors found";
+            lexer.error(colors_token, anError.str());
+        }
+    }
+
+    // Seek the node count.
+    while (!found && lexer.next(token))
     {
+        if (token.is(CONST_STRING_CONFIG_COMMENT_KEYWORD)) lexer.skip_line();
+        else found = token.is(CONST_STRING_CONFIG_NUM_NODES_KEYWORD);
+    }
+    if (!found) lexer.error_at_end("missing \"" + CONST_STRING_CONFIG_NUM_NODES_KEYWORD + "\"");
+
+    if (!lexer.next(token)) lexer.error_at_end("missing node count");
+    rgb_config_token count_token = token;
+    unsigned long expected = lexer.to_count(token);
 
-        ifstream node_config_file(aNodeConfig.c_str());
+    // A #NODE line takes at least 9 bytes, so a bigger count than that
+    //  is not trusted for the reservation.
+    node_vector.reserve((expected < size / 9) ? expected : size / 9);
 
-        if (!node_config_file)
+    rgb_node temp_node;
+    bool ended = false;
+    while (!ended && lexer.next(token))
+    {
+        if (token.is(CONST_STRING_CONFIG_NODE_KEYWORD))
         {
-            // Unable to open the config file for reading....
-            //  This is an error.
-            aLogger->throw_exception(ENUM_UNABLE_TO_READ_CONFIG,
-                "Unable to open node config for reading.  Check the input config file.",
-                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+            // #NODE <NAME> <R> <G> <B>  or  #NODE <NAME> <COLOR_NUMBER>
+            rgb_config_token name, red, green, blue;
+            if (!lexer.next(name) || !lexer.next(red) ||
+                (!parse_palette && (!lexer.next(green) || !lexer.next(blue))))
+            {
+                lexer.error(token, "incomplete \"" + CONST_STRING_CONFIG_NODE_KEYWORD + "\"");
+            }
+
+            if (parse_palette)
+            {
+                unsigned long color = lexer.to_count(red);
+                if (color >= palette.size())
+                {
+                    lexer.error(red, "color number " + red.str() + " is not in the palette");
+                }
+                temp_node = palette[color];
+            }
+            else
+            {
+                temp_node.set_red(lexer.to_color(red));
+                temp_node.set_green(lexer.to_color(green));
+                temp_node.set_blue(lexer.to_color(blue));
+            }
+            temp_node.set_name(name.str());
+            node_vector.push_back(temp_node);
         }
-
-        while ((node_config_file >> aWord) &&
-                node_config_file.good())
+        else if (token.is(CONST_STRING_CONFIG_END_KEYWORD))
         {
-            process(aWord);
+            // #END keyword means this config is finished.
+            ended = true;
+        }
+        else if (token.is(CONST_STRING_CONFIG_COMMENT_KEYWORD))
+        {
+            lexer.skip_line();
         }
     }
 
-//cout << "Expected: " << parse_config_number_of_nodes << " Read :"  << parse_config_vector.size() << endl;
+    if (node_vector.size() != expected)
+    {
+        stringstream anError;
+        anError << CONST_STRING_CONFIG_NUM_NODES_KEYWORD << " " << expected
+            << " does not match the " << node_vector.size() << " nodes found";
+        lexer.error(count_token, anError.str());
+    }
+}
 
-    // Success
-    node_vector = parse_config_vector;
-    clear(); // Clear out existing code
-    
+// Text for the "#COMMENT created :" line.  Taken once per run so every
+//  config written by the run carries the same time.
+static string make_timestamp()
+{
+    time_t rawtime;
+    struct tm timeinfo;
+    char text[64];
+    time(&rawtime);
+    localtime_r(&rawtime, &timeinfo);
+    return asctime_r(&timeinfo, text);
 }
 
+static string const &creation_timestamp()
+{
+    static const string timestamp = make_timestamp();
+    return timestamp;
+}
 
-void rgb_configio::create_node_config(vector<rgb_node> const &node_vector,
-    string const &source_file,
-    string &aNodeConfig)
+// Palette key: the bit patterns of the three colors.
+class rgb_color_key
 {
-    // This assumes that the node_vector is not empty.
+public:
+    rgb_color_key(rgb_node const &aNode) {
+        float colors[3] = { aNode.get_red(), aNode.get_green(), aNode.get_blue() };
+        memcpy(bits, colors, sizeof(bits));
+    }
+
+    bool operator == (rgb_color_key const &A) const {
+        return memcmp(bits, A.bits, sizeof(bits)) == 0;
+    }
 
+    uint32_t bits[3];
+};
+
+class rgb_color_key_hash
+{
+public:
+    size_t operator () (rgb_color_key const &A) const {
+        return rgb_hash::hash(A.bits, sizeof(A.bits));
+    }
+};
+
+void rgb_configio::build_palette(vector<rgb_node> const &node_vector,
+    vector<unsigned int> &palette,
+    vector<unsigned int> &node_colors)
+{
+    // palette holds the position of the first node with each color.
+    palette.clear();
+    node_colors.resize(node_vector.size());
+
+    unordered_map<rgb_color_key, unsigned int, rgb_color_key_hash> seen;
+    for (unsigned int ii = 0; ii < node_vector.size(); ii++)
+    {
+        pair<unordered_map<rgb_color_key, unsigned int, rgb_color_key_hash>::iterator, bool> 
+            entry = seen.insert(make_pair(rgb_color_key(node_vector[ii]), palette.size()));
+        if (entry.second) palette.push_back(ii);
+        node_colors[ii] = entry.first->second;
+    }
+}
+
+void rgb_configio::write_node_config(ostream &out,
+    vector<rgb_node> const &node_vector,
+    string const &source_file)
+{
     // Config file will be in the form:
     // #START V001
     // #COMMENT __COMMENT_HERE__
@@ -105,33 +333,61 @@ void rgb_configio::create_node_config(vector<rgb_node> const &node_vector,
     // #NODE node_name RED GREEN BLUE
     // #END 
     // it will include all following whitespace
+    //  With the palette on the colors are listed once (#NUM_COLORS and
+    //  #COLOR lines) and each #NODE names its color by number.
+    out << CONST_STRING_CONFIG_START_KEYWORD << " " 
+        << (palette ? CONST_STRING_CONFIG_PALETTE_VERSION : CONST_STRING_CONFIG_CURRENT_VERSION) << "\n";
+    out << CONST_STRING_CONFIG_COMMENT_KEYWORD << " source file : " << source_file << "\n";
 
-    stringstream config;
-    config.clear();
-
-    // Construct the config file 
-    config << CONST_STRING_CONFIG_START_KEYWORD << " " << CONST_STRING_CONFIG_CURRENT_VERSION << "\n";
-    config << CONST_STRING_CONFIG_COMMENT_KEYWORD << " source file : " << source_file << "\n";
-
-    // Create and add a timestamp
-    time_t rawtime;
-    struct tm * timeinfo;
-    time ( &rawtime );
-    timeinfo = localtime ( &rawtime );
+    if (timestamp)
+    {
+        out << CONST_STRING_CONFIG_COMMENT_KEYWORD << " created : " << creation_timestamp();
+    }
 
-    config << CONST_STRING_CONFIG_COMMENT_KEYWORD << " created : " << asctime (timeinfo);
+    // "%g" is the default ostream float format, so the colors are written
+    //  exactly as before.
+    char colors[64];
+    if (palette)
+    {
+        vector<unsigned int> palette_nodes, node_colors;
+        build_palette(node_vector, palette_nodes, node_colors);
+
+        out << CONST_STRING_CONFIG_NUM_COLORS_KEYWORD << " " << palette_nodes.size() << "\n";
+        for (unsigned int ii = 0; ii < palette_nodes.size(); ii++) {
+            rgb_node const &aNode = node_vector[palette_nodes[ii]];
+            int size = snprintf(colors, sizeof(colors), " %g %g %g\n",
+                aNode.get_red(), aNode.get_green(), aNode.get_blue());
+            out << CONST_STRING_CONFIG_COLOR_KEYWORD;
+            out.write(colors, size);
+        }
 
-    config << CONST_STRING_CONFIG_NUM_NODES_KEYWORD << " " << node_vector.size() << "\n";
-    //for (vector<rgb_node>::iterator it = node_vector.begin(); it < node_vector.end(); it++ ) {
-    for (unsigned int ii = 0; ii < node_vector.size(); ii++) {
-        config << CONST_STRING_CONFIG_NODE_KEYWORD << " ";
-        config << node_vector[ii].get_name() << " ";
-        config << node_vector[ii].get_red() << " ";
-        config << node_vector[ii].get_green() << " ";
-        config << node_vector[ii].get_blue() << endl;
+        out << CONST_STRING_CONFIG_NUM_NODES_KEYWORD << " " << node_vector.size() << "\n";
+        for (unsigned int ii = 0; ii < node_vector.size(); ii++) {
+            out << CONST_STRING_CONFIG_NODE_KEYWORD << " " << node_vector[ii].get_name()
+                << " " << node_colors[ii] << "\n";
+        }
+    }
+    else
+    {
+        out << CONST_STRING_CONFIG_NUM_NODES_KEYWORD << " " << node_vector.size() << "\n";
+        for (unsigned int ii = 0; ii < node_vector.size(); ii++) {
+            rgb_node const &aNode = node_vector[ii];
+            int size = snprintf(colors, sizeof(colors), " %g %g %g\n",
+                aNode.get_red(), aNode.get_green(), aNode.get_blue());
+            out << CONST_STRING_CONFIG_NODE_KEYWORD << " " << aNode.get_name();
+            out.write(colors, size);
+        }
     }
-    config << CONST_STRING_CONFIG_END_KEYWORD << endl << endl;
+    out << CONST_STRING_CONFIG_END_KEYWORD << "\n\n";
+}
 
+void rgb_configio::create_node_config(vector<rgb_node> const &node_vector,
+    string const &source_file,
+    string &aNodeConfig)
+{
+    // This assumes that the node_vector is not empty.
+    stringstream config;
+    write_node_config(config, node_vector, source_file);
     aNodeConfig = config.str();
 }
 
@@ -139,108 +395,261 @@ void rgb_configio::write_node_config_file(vector<rgb_node> const &node_vector,
     string const &source_file,
     string const &output_file)
 {
-    string aConfig;
-    create_node_config(node_vector, source_file, aConfig);
-
-    // Write config file to the output_file
-    ofstream out_file(output_file.c_str(), ios::out | ios::trunc);
-
-    if (out_file.is_open()) {
-        out_file << aConfig;
-        out_file.close();
-    }
-    else 
-    {
+    // Nodes are formatted straight into the file buffer so memory use
+    //  does not grow with the config.  The buffer must outlive the stream.
+    vector<char> buffer(CONST_CONFIG_WRITE_BUFFER_SIZE);
+    ofstream out_file;
+    out_file.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+    out_file.open(output_file.c_str(), ios::out | ios::trunc);
+
+    if (!out_file.is_open()) {
         aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
             "Unable to open node config file for writing.  Is the directory full?", 
             __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
     } 
+
+    write_node_config(out_file, node_vector, source_file);
+    out_file.close();
+
+    if (out_file.fail()) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to write node config file \"" + output_file + "\".  Is the directory full?",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
 }
 
-void rgb_configio::STATE_seek_START(string const &aWord)
+string rgb_configio::converted_file_name(string const &input_file,
+    string const &from_extention,
+    string const &to_extention)
 {
-DEBUG_BLAH
-    STATE_verify_required_word(
-        STRING_error_layer,
-        aWord,
-        CONST_STRING_CONFIG_START_KEYWORD,
-        (STATE)&rgb_configio::STATE_seek_CONFIG_VERSION);
+    // "x_rgb_nodes.txt" becomes "x_rgb_nodes.bin" and the other way
+    //  around.  Anything else just gets the new extention added.
+    if ((input_file.size() > from_extention.size()) &&
+        (input_file.compare(input_file.size() - from_extention.size(),
+            from_extention.size(), from_extention) == 0))
+    {
+        return input_file.substr(0, input_file.size() - from_extention.size())
+            + to_extention;
+    }
+    return input_file + to_extention;
 }
 
-void rgb_configio::STATE_seek_CONFIG_VERSION(string const &aWord)
+void rgb_configio::convert_to_binary(string const &config_file, string const &binary_file)
 {
-DEBUG_BLAH
-    STATE_verify_required_word(
-        STRING_error_layer,
-        aWord,
-        CONST_STRING_CONFIG_CURRENT_VERSION,
-        (STATE)&rgb_configio::STATE_seek_NUM_NODES_KEYWORD);
+    vector<rgb_node> node_vector;
+    parse_node_config(config_file, node_vector);
+
+    string output_file = binary_file;
+    if (output_file.empty()) {
+        output_file = converted_file_name(config_file,
+            CONST_STRING_DEFAULT_RGB_NODE_FILE_EXTENTION,
+            CONST_STRING_DEFAULT_RGB_BINARY_FILE_EXTENTION);
+    }
+
+    rgb_binaryio binaryIO;
+    binaryIO.write_node_binary_file(node_vector, config_file, output_file);
 }
 
-void rgb_configio::STATE_seek_NUM_NODES_KEYWORD(string const &aWord)
+void rgb_configio::convert_to_text(string const &binary_file, string const &config_file)
 {
-DEBUG_BLAH
-    if (aWord == CONST_STRING_CONFIG_NUM_NODES_KEYWORD)
-    {
-        // #NUM_NODES keyword found ... read the number of
-        //  nodes to find.
-        TRAN((STATE)&rgb_configio::STATE_read_NUM_NODES);
+    rgb_binary_view view;
+    view.open(binary_file);
+
+    vector<rgb_node> node_vector;
+    view.to_nodes(node_vector);
+
+    string output_file = config_file;
+    if (output_file.empty()) {
+        output_file = converted_file_name(binary_file,
+            CONST_STRING_DEFAULT_RGB_BINARY_FILE_EXTENTION,
+            CONST_STRING_DEFAULT_RGB_NODE_FILE_EXTENTION);
     }
-}
 
+    write_node_config_file(node_vector, view.source(), output_file);
+}
 
-void rgb_configio::STATE_read_NUM_NODES(string const &aWord)
+rgb_node_table::rgb_node_table(vector<rgb_node> const &node_vector, bool aPalette)
+: palette(aPalette)
 {
-    parse_config_number_of_nodes = atoi(aWord.c_str());
-    TRAN((STATE)&rgb_configio::STATE_read_NODE_KEYWORD);
+    columns.assign(node_vector);
+    count = columns.size();
+    reds = count ? &columns.red[0] : NULL;
+    greens = count ? &columns.green[0] : NULL;
+    blues = count ? &columns.blue[0] : NULL;
 }
 
-void rgb_configio::STATE_read_NODE_KEYWORD(string const &aWord)
+rgb_node_table::rgb_node_table(string const &binary_file)
+: palette(false)
 {
-    if (aWord == CONST_STRING_CONFIG_NODE_KEYWORD)
-    {
-        // Start of a #NODE <NAME> <R> <G> <B> sequence
-        TRAN((STATE)&rgb_configio::STATE_read_NODE_NAME);
-    }
-    if (aWord == CONST_STRING_CONFIG_END_KEYWORD)
+    view.open(binary_file);
+    count = view.size();
+    reds = view.red_column();
+    greens = view.green_column();
+    blues = view.blue_column();
+
+    if ((count > 0) && !reds)
     {
-        // #END keyword means this config is finished.
-        // transition to NOOP and do nothing else
-        TRAN((STATE)&rgb_configio::STATE_NOOP);
+        // Not in host byte order.  The colors are decoded once; the names
+        //  are still read in place.
+        columns.red.resize(count);
+        columns.green.resize(count);
+        columns.blue.resize(count);
+        for (size_t ii = 0; ii < count; ii++) {
+            columns.red[ii] = view.red(ii);
+            columns.green[ii] = view.green(ii);
+            columns.blue[ii] = view.blue(ii);
+        }
+        reds = &columns.red[0];
+        greens = &columns.green[0];
+        blues = &columns.blue[0];
     }
 }
 
-void rgb_configio::STATE_read_NODE_NAME(string const &aWord)
+string rgb_node_table::name(size_t index) const
 {
-    parse_temp_node.set_name(aWord);
-    TRAN((STATE)&rgb_configio::STATE_read_RED);
+    return view.is_open() ? view.name(index) : columns.name[index];
 }
 
-void rgb_configio::STATE_read_RED(string const &aWord)
+rgb_node rgb_node_table::node(size_t index) const
 {
-    parse_temp_node.set_red(atof(aWord.c_str()));
-    TRAN((STATE)&rgb_configio::STATE_read_GREEN);
+    rgb_node temp;
+    temp.set_name(name(index));
+    temp.set_red(reds[index]);
+    temp.set_green(greens[index]);
+    temp.set_blue(blues[index]);
+    return temp;
 }
 
-void rgb_configio::STATE_read_GREEN(string const &aWord)
+long rgb_node_table::find(string const &aName) const
 {
-    parse_temp_node.set_green(atof(aWord.c_str()));
-    TRAN((STATE)&rgb_configio::STATE_read_BLUE);
+    call_once(index_built, &rgb_node_table::build_index, this);
+    return index.find(aName);
 }
 
-void rgb_configio::STATE_read_BLUE(string const &aWord)
+void rgb_node_table::build_index() const
 {
-    parse_temp_node.set_blue(atof(aWord.c_str()));
-    TRAN((STATE)&rgb_configio::STATE_read_NODE_KEYWORD);
+    if (!view.is_open())
+    {
+        index.build(columns.name);
+        return;
+    }
 
-    // Save the completed RGB node in the vector
-    parse_config_vector.push_back(parse_temp_node);
-    parse_temp_node.clear();
+    vector<string> names;
+    names.reserve(count);
+    for (size_t ii = 0; ii < count; ii++) {
+        names.push_back(view.name(ii));
+    }
+    index.build(names);
 }
 
-void rgb_configio::STATE_NOOP(string)
+rgb_node_table_ptr rgb_config_cache::load(string const &aNodeConfig)
 {
-    // Do nothing...
+    // A binary node file is mapped, not parsed.
+    if (rgb_binaryio::is_binary_file(aNodeConfig))
+    {
+        return rgb_node_table_ptr(new rgb_node_table(aNodeConfig));
+    }
+
+    vector<rgb_node> node_vector;
+    rgb_configio configIO;
+    configIO.parse_node_config(aNodeConfig, node_vector);
+    return rgb_node_table_ptr(new rgb_node_table(node_vector, configIO.parsed_palette()));
+}
+
+rgb_node_table_ptr rgb_config_cache::get(string const &aNodeConfig)
+{
+    promise<rgb_node_table_ptr> loading;
+    shared_future<rgb_node_table_ptr> table;
+    bool first = false;
+    {
+        lock_guard<mutex> lock(table_mutex);
+        map<string, shared_future<rgb_node_table_ptr> >::iterator it = tables.find(aNodeConfig);
+        if (it == tables.end())
+        {
+            table = loading.get_future().share();
+            tables[aNodeConfig] = table;
+            first = true;
+        }
+        else {
+            table = it->second;
+        }
+    }
+
+    if (first)
+    {
+        // First use of this config.  A config that cannot be read or
+        //  parsed is not tried again: the error, text and code, stays in
+        //  the slot and every later get() throws it.  Anything else is
+        //  thrown to the callers waiting now and not stored.
+        try {
+            loading.set_value(load(aNodeConfig));
+        }
+        catch (ErrException &) {
+            loading.set_exception(current_exception());
+        }
+        catch (...) {
+            {
+                lock_guard<mutex> lock(table_mutex);
+                tables.erase(aNodeConfig);
+            }
+            loading.set_exception(current_exception());
+        }
+    }
+    return table.get();
 }
 
+rgb_node_table_ptr rgb_config_cache::get(string const &aNodeConfig,
+    string const &aSourceFile)
+{
+    shared_ptr<rgb_bundle> bundle;
+    {
+        lock_guard<mutex> lock(table_mutex);
+        map<string, ErrException>::const_iterator failed = bundle_failures.find(aNodeConfig);
+        if (failed != bundle_failures.end()) {
+            throw failed->second;
+        }
 
+        map<string, shared_ptr<rgb_bundle> >::iterator it = bundles.find(aNodeConfig);
+        if (it == bundles.end())
+        {
+            if (rgb_bundle::is_bundle_file(aNodeConfig)) {
+                try {
+                    bundle.reset(new rgb_bundle);
+                    bundle->open(aNodeConfig);
+                }
+                catch (ErrException &e) {
+                    // A damaged bundle is not opened again for every file.
+                    bundle_failures.insert(make_pair(aNodeConfig, e));
+                    throw;
+                }
+            }
+            bundles[aNodeConfig] = bundle;
+        }
+        else {
+            bundle = it->second;
+        }
+    }
+
+    if (!bundle) {
+        return get(aNodeConfig);
+    }
+
+    // The entry is checked and parsed without the lock.
+    const char *data;
+    uint64_t length;
+    bundle->find(aSourceFile, data, length);
+
+    vector<rgb_node> node_vector;
+    rgb_configio configIO;
+    configIO.parse_node_config_buffer(data, length,
+        "\"" + aNodeConfig + "\" entry \"" + aSourceFile + "\"", node_vector);
+
+    return rgb_node_table_ptr(new rgb_node_table(node_vector, configIO.parsed_palette()));
+}
+
+bool rgb_config_cache::is_bundle(string const &aNodeConfig)
+{
+    lock_guard<mutex> lock(table_mutex);
+    map<string, shared_ptr<rgb_bundle> >::const_iterator it = bundles.find(aNodeConfig);
+    return (it != bundles.end()) && it->second;
+}
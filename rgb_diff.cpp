@@ -0,0 +1,545 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_diff.cpp
+##  This file defines the methods used to diff a VRML file against a config
+##   or against another VRML file.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_diff_h__
+#include "include/rgb_diff.h"
+#endif
+
+#ifndef __rgb_hash_h__
+#include "include/rgb_hash.h"
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+static string diff_color(rgb_node const *aNode)
+{
+    if (aNode == NULL) return "-";
+
+    char colors[64];
+    snprintf(colors, sizeof(colors), "%g %g %g",
+        aNode->get_red(), aNode->get_green(), aNode->get_blue());
+    return colors;
+}
+
+static string diff_index(long index)
+{
+    if (index < 0) return "-";
+
+    char number[32];
+    snprintf(number, sizeof(number), "%ld", index);
+    return number;
+}
+
+static uint64_t name_hash(rgb_node const &aNode)
+{
+    string name = aNode.get_name();
+    return rgb_hash::hash(name.data(), name.size());
+}
+
+bool rgb_diff::diff(string const &aFileName, rgb_node_table const &config_table,
+    ostream &out)
+{
+    clear();
+    file_name = aFileName;
+    file_nodes.clear();
+
+    extractor.open_stream(file_name);
+    try {
+        switch (mode) {
+        case ENUM_DIFF_BY_POSITION:
+            diff_by_position(config_table, out);
+            break;
+        case ENUM_DIFF_BY_NAME:
+            diff_by_name(config_table, out);
+            break;
+        default:
+            diff_aligned(config_table, out);
+            break;
+        }
+    }
+    catch (...) {
+        extractor.close_stream();
+        file_nodes.clear();
+        throw;
+    }
+    extractor.close_stream();
+    file_nodes.clear();
+
+    return (changed + added + removed) == 0;
+}
+
+void rgb_diff_window::push(rgb_node const &aNode)
+{
+    positions[aNode.get_name()].push_back(first + nodes.size());
+    nodes.push_back(aNode);
+}
+
+void rgb_diff_window::pop()
+{
+    // The front node is always the first position listed for its name.
+    unordered_map<string, deque<size_t> >::iterator it =
+        positions.find(nodes.front().get_name());
+    it->second.pop_front();
+    if (it->second.empty()) {
+        positions.erase(it);
+    }
+    nodes.pop_front();
+    first++;
+}
+
+long rgb_diff_window::find(string const &aName) const
+{
+    unordered_map<string, deque<size_t> >::const_iterator it = positions.find(aName);
+    if (it == positions.end()) return -1;
+    return it->second.front() - first;
+}
+
+bool rgb_diff::diff_files(string const &new_file, string const &old_file,
+    ostream &out)
+{
+    clear();
+    file_name = new_file;
+
+    extractor.open_stream(new_file);
+    try {
+        old_extractor.open_stream(old_file);
+        if (mode == ENUM_DIFF_BY_POSITION) {
+            stream_by_position(out);
+        }
+        else {
+            stream_merge(out);
+        }
+    }
+    catch (...) {
+        extractor.close_stream();
+        old_extractor.close_stream();
+        throw;
+    }
+    extractor.close_stream();
+    old_extractor.close_stream();
+
+    return (changed + added + removed) == 0;
+}
+
+void rgb_diff::stream_by_position(ostream &out)
+{
+    rgb_node new_node;
+    rgb_node old_node;
+    long index = 0;
+    for (;;) {
+        bool have_new = extractor.next_node(new_node);
+        bool have_old = old_extractor.next_node(old_node);
+        if (have_new && have_old) {
+            compare_nodes(index, &new_node, index, &old_node, out);
+        }
+        else if (have_new) {
+            report(ENUM_DIFF_ADDED, index, &new_node, -1, NULL, out);
+        }
+        else if (have_old) {
+            report(ENUM_DIFF_REMOVED, -1, NULL, index, &old_node, out);
+        }
+        else {
+            break;
+        }
+        index++;
+    }
+}
+
+void rgb_diff::fill(rgb_extract &anExtractor, rgb_diff_window &aWindow)
+{
+    rgb_node aNode;
+    while ((!aWindow.done) && (aWindow.size() < CONST_DIFF_WINDOW_SIZE)) {
+        if (anExtractor.next_node(aNode)) {
+            aWindow.push(aNode);
+        }
+        else {
+            aWindow.done = true;
+        }
+    }
+}
+
+void rgb_diff::stream_merge(ostream &out)
+{
+    // Both files are read into a window.  Nodes with the same name at the
+    //  front are paired.  Otherwise the nearer of the two fronts found
+    //  in the other window decides which side skipped nodes.
+    rgb_diff_window new_nodes;
+    rgb_diff_window old_nodes;
+
+    for (;;) {
+        fill(extractor, new_nodes);
+        fill(old_extractor, old_nodes);
+
+        if (new_nodes.empty() && old_nodes.empty()) {
+            break;
+        }
+        if (old_nodes.empty()) {
+            report(ENUM_DIFF_ADDED, new_nodes.first, &new_nodes.front(), -1, NULL, out);
+            new_nodes.pop();
+            continue;
+        }
+        if (new_nodes.empty()) {
+            report(ENUM_DIFF_REMOVED, -1, NULL, old_nodes.first, &old_nodes.front(), out);
+            old_nodes.pop();
+            continue;
+        }
+
+        if (new_nodes.front().get_name() == old_nodes.front().get_name()) {
+            compare_nodes(new_nodes.first, &new_nodes.front(),
+                old_nodes.first, &old_nodes.front(), out);
+            new_nodes.pop();
+            old_nodes.pop();
+            continue;
+        }
+
+        long added_run = new_nodes.find(old_nodes.front().get_name());
+        long removed_run = old_nodes.find(new_nodes.front().get_name());
+        if ((added_run >= 0) && ((removed_run < 0) || (added_run <= removed_run))) {
+            for (; added_run > 0; added_run--) {
+                report(ENUM_DIFF_ADDED, new_nodes.first, &new_nodes.front(), -1, NULL, out);
+                new_nodes.pop();
+            }
+        }
+        else if (removed_run >= 0) {
+            for (; removed_run > 0; removed_run--) {
+                report(ENUM_DIFF_REMOVED, -1, NULL, old_nodes.first, &old_nodes.front(), out);
+                old_nodes.pop();
+            }
+        }
+        else {
+            // Neither front is in the other window.
+            report(ENUM_DIFF_REMOVED, -1, NULL, old_nodes.first, &old_nodes.front(), out);
+            report(ENUM_DIFF_ADDED, new_nodes.first, &new_nodes.front(), -1, NULL, out);
+            old_nodes.pop();
+            new_nodes.pop();
+        }
+    }
+}
+
+void rgb_diff::diff_by_position(rgb_node_table const &config_table, ostream &out)
+{
+    rgb_node aNode;
+    long index = 0;
+    while (extractor.next_node(aNode)) {
+        if ((size_t)index < config_table.size()) {
+            rgb_node config_node = config_table.node(index);
+            compare_nodes(index, &aNode, index, &config_node, out);
+        }
+        else {
+            report(ENUM_DIFF_ADDED, index, &aNode, -1, NULL, out);
+        }
+        index++;
+    }
+
+    for (; (size_t)index < config_table.size(); index++) {
+        rgb_node config_node = config_table.node(index);
+        report(ENUM_DIFF_REMOVED, -1, NULL, index, &config_node, out);
+    }
+}
+
+void rgb_diff::diff_by_name(rgb_node_table const &config_table, ostream &out)
+{
+    vector<bool> seen(config_table.size(), false);
+
+    // A repeated name pairs with the first config node of that name once;
+    //  later copies in the file are reported as added.
+    rgb_node aNode;
+    long index = 0;
+    while (extractor.next_node(aNode)) {
+        long position = config_table.find(aNode.get_name());
+        if ((position == CONST_NODE_INDEX_NOT_FOUND) || seen[position]) {
+            report(ENUM_DIFF_ADDED, index, &aNode, -1, NULL, out);
+        }
+        else {
+            seen[position] = true;
+            rgb_node config_node = config_table.node(position);
+            compare_nodes(index, &aNode, position, &config_node, out);
+        }
+        index++;
+    }
+
+    for (size_t ii = 0; ii < config_table.size(); ii++) {
+        if (!seen[ii]) {
+            rgb_node config_node = config_table.node(ii);
+            report(ENUM_DIFF_REMOVED, -1, NULL, ii, &config_node, out);
+        }
+    }
+}
+
+void rgb_diff::diff_aligned(rgb_node_table const &config_table, ostream &out)
+{
+    // The common prefix is compared as the file streams in.  Only the
+    //  nodes from the first renamed, added or removed node on are held.
+    rgb_node aNode;
+    size_t prefix = 0;
+    while (extractor.next_node(aNode)) {
+        if ((prefix < config_table.size()) && (aNode.get_name() == config_table.name(prefix))) {
+            rgb_node config_node = config_table.node(prefix);
+            compare_nodes(prefix, &aNode, prefix, &config_node, out);
+            prefix++;
+            continue;
+        }
+        file_nodes.push_back(aNode);
+        break;
+    }
+    while (extractor.next_node(aNode)) {
+        file_nodes.push_back(aNode);
+    }
+
+    file_offset = prefix;
+    align(config_table, prefix, config_table.size(), 0, file_nodes.size(), out);
+}
+
+void rgb_diff::align(rgb_node_table const &config_nodes,
+    size_t config_begin, size_t config_end,
+    size_t file_begin, size_t file_end,
+    ostream &out)
+{
+    // Common suffix.  It is reported after the middle to keep file order.
+    size_t suffix = 0;
+    while ((file_end - suffix > file_begin) && (config_end - suffix > config_begin) &&
+        (file_nodes[file_end - suffix - 1].get_name() ==
+            config_nodes.name(config_end - suffix - 1)))
+    {
+        suffix++;
+    }
+    file_end -= suffix;
+    config_end -= suffix;
+
+    // Myers' greedy O((N+M)D) search for the shortest edit script that
+    //  turns the config names into the file names.  a is the file, b the
+    //  config.
+    long N = file_end - file_begin;
+    long M = config_end - config_begin;
+
+    vector<uint64_t> a_hash(N);
+    vector<uint64_t> b_hash(M);
+    for (long ii = 0; ii < N; ii++) a_hash[ii] = name_hash(file_nodes[file_begin + ii]);
+    vector<string> b_name(M);
+    for (long ii = 0; ii < M; ii++) {
+        b_name[ii] = config_nodes.name(config_begin + ii);
+        b_hash[ii] = rgb_hash::hash(b_name[ii].data(), b_name[ii].size());
+    }
+
+    long max_d = min(N + M, CONST_DIFF_MAX_EDIT_DISTANCE);
+    long offset = max_d + 1;
+    vector<long> v(2 * max_d + 3, 0);
+    // The furthest x of every diagonal after each step.  Step d is kept
+    //  at trace[d*d], diagonal k at k+d.
+    vector<long> trace;
+    long edits = -1;
+
+    for (long d = 0; (d <= max_d) && (edits < 0); d++) {
+        for (long k = -d; k <= d; k += 2) {
+            long x;
+            if ((k == -d) || ((k != d) && (v[offset + k - 1] < v[offset + k + 1]))) {
+                x = v[offset + k + 1];
+            }
+            else {
+                x = v[offset + k - 1] + 1;
+            }
+            long y = x - k;
+            while ((x < N) && (y < M) && (a_hash[x] == b_hash[y]) &&
+                (file_nodes[file_begin + x].get_name() == b_name[y]))
+            {
+                x++;
+                y++;
+            }
+            v[offset + k] = x;
+            if ((x >= N) && (y >= M)) {
+                edits = d;
+                break;
+            }
+        }
+        trace.insert(trace.end(), v.begin() + offset - d, v.begin() + offset + d + 1);
+    }
+
+    if (edits < 0) {
+        // Too many edits to align.  Fall back to matching by name.
+        match_names(config_nodes, config_begin, config_end, file_begin, file_end, out);
+    }
+    else {
+        // Walk the trace back from the end.  Steps are (file, config)
+        //  positions; -1 is a node only on the other side.
+        vector< std::pair<long, long> > steps;
+        long x = N;
+        long y = M;
+        for (long d = edits; d > 0; d--) {
+            const long *prev = &trace[(d - 1) * (d - 1)] + (d - 1);
+            long k = x - y;
+            long prev_k;
+            if ((k == -d) || ((k != d) && (prev[k - 1] < prev[k + 1]))) {
+                prev_k = k + 1;
+            }
+            else {
+                prev_k = k - 1;
+            }
+            long prev_x = prev[prev_k];
+            long prev_y = prev_x - prev_k;
+
+            while ((x > prev_x) && (y > prev_y)) {
+                x--;
+                y--;
+                steps.push_back(std::make_pair(x, y));
+            }
+            if (prev_k == k + 1) {
+                y--;
+                steps.push_back(std::make_pair(-1L, y));
+            }
+            else {
+                x--;
+                steps.push_back(std::make_pair(x, -1L));
+            }
+        }
+        while ((x > 0) && (y > 0)) {
+            x--;
+            y--;
+            steps.push_back(std::make_pair(x, y));
+        }
+
+        for (size_t ii = steps.size(); ii > 0; ii--) {
+            long file_index = steps[ii - 1].first;
+            long config_index = steps[ii - 1].second;
+            if (file_index < 0) {
+                rgb_node config_node = config_nodes.node(config_begin + config_index);
+                report(ENUM_DIFF_REMOVED, -1, NULL, config_begin + config_index,
+                    &config_node, out);
+            }
+            else if (config_index < 0) {
+                report(ENUM_DIFF_ADDED, file_offset + file_begin + file_index,
+                    &file_nodes[file_begin + file_index], -1, NULL, out);
+            }
+            else {
+                rgb_node config_node = config_nodes.node(config_begin + config_index);
+                compare_nodes(file_offset + file_begin + file_index, &file_nodes[file_begin + file_index],
+                    config_begin + config_index, &config_node, out);
+            }
+        }
+    }
+
+    for (size_t ii = 0; ii < suffix; ii++) {
+        rgb_node config_node = config_nodes.node(config_end + ii);
+        compare_nodes(file_offset + file_end + ii, &file_nodes[file_end + ii],
+            config_end + ii, &config_node, out);
+    }
+}
+
+void rgb_diff::match_names(rgb_node_table const &config_nodes,
+    size_t config_begin, size_t config_end,
+    size_t file_begin, size_t file_end,
+    ostream &out)
+{
+    unordered_map<string, size_t> names;
+    for (size_t ii = config_begin; ii < config_end; ii++) {
+        names.insert(std::make_pair(config_nodes.name(ii), ii));
+    }
+
+    vector<bool> seen(config_end - config_begin, false);
+    for (size_t ii = file_begin; ii < file_end; ii++) {
+        unordered_map<string, size_t>::iterator it = names.find(file_nodes[ii].get_name());
+        if ((it == names.end()) || seen[it->second - config_begin]) {
+            report(ENUM_DIFF_ADDED, file_offset + ii, &file_nodes[ii], -1, NULL, out);
+        }
+        else {
+            seen[it->second - config_begin] = true;
+            rgb_node config_node = config_nodes.node(it->second);
+            compare_nodes(file_offset + ii, &file_nodes[ii], it->second, &config_node, out);
+        }
+    }
+
+    for (size_t ii = config_begin; ii < config_end; ii++) {
+        if (!seen[ii - config_begin]) {
+            rgb_node config_node = config_nodes.node(ii);
+            report(ENUM_DIFF_REMOVED, -1, NULL, ii, &config_node, out);
+        }
+    }
+}
+
+void rgb_diff::compare_nodes(long file_index, rgb_node const *file_node,
+    long config_index, rgb_node const *config_node,
+    ostream &out)
+{
+    if (comparator.equal(*file_node, *config_node)) {
+        matched++;
+        return;
+    }
+    report(ENUM_DIFF_CHANGED, file_index, file_node, config_index, config_node, out);
+}
+
+void rgb_diff::report(enum RGB_DIFF_KIND kind,
+    long file_index, rgb_node const *file_node,
+    long config_index, rgb_node const *config_node,
+    ostream &out)
+{
+    switch (kind) {
+    case ENUM_DIFF_CHANGED: changed++; break;
+    case ENUM_DIFF_ADDED: added++; break;
+    case ENUM_DIFF_REMOVED: removed++; break;
+    }
+
+    string file_name_field = file_node ? file_node->get_name() : "-";
+    string config_name_field = config_node ? config_node->get_name() : "-";
+
+    if (format == ENUM_DIFF_MACHINE) {
+        static const char *kind_name[] = { "changed", "added", "removed" };
+        out << kind_name[kind] << '\t' << file_name << '\t'
+            << diff_index(file_index) << '\t' << diff_index(config_index) << '\t'
+            << file_name_field << '\t' << config_name_field << '\t'
+            << diff_color(config_node) << '\t' << diff_color(file_node) << '\n';
+        return;
+    }
+
+    // "~ file/config name : config color -> file color"
+    static const char kind_mark[] = { '~', '+', '-' };
+    out << "  " << kind_mark[kind] << " "
+        << diff_index(file_index) << "/" << diff_index(config_index) << " ";
+    if ((file_node == NULL) || (config_node == NULL) ||
+        (file_name_field == config_name_field))
+    {
+        out << (file_node ? file_name_field : config_name_field);
+    }
+    else {
+        out << file_name_field << " (was " << config_name_field << ")";
+    }
+
+    switch (kind) {
+    case ENUM_DIFF_CHANGED:
+        out << " : " << diff_color(config_node) << " -> " << diff_color(file_node);
+        break;
+    case ENUM_DIFF_ADDED:
+        out << " : " << diff_color(file_node);
+        break;
+    case ENUM_DIFF_REMOVED:
+        out << " : " << diff_color(config_node);
+        break;
+    }
+    out << '\n';
+}
@@ -39,14 +39,41 @@
 #include "include/rgb_configio.h"
 #endif
 
+#ifndef __rgb_binaryio_h__
+#include "include/rgb_binaryio.h"
+#endif
+
+#ifndef __rgb_hash_h__
+#include "include/rgb_hash.h"
+#endif
+
 void rgb_extract::extract_nodes(string const &in_file, vector<rgb_node> &rgb_list_vector)
 {
-    // This will throw an exception if it cannot open the source file.
-    rgb_fileio input_file(in_file.c_str());
+    if (!node_cache)
+    {
+        parse_nodes(in_file, rgb_list_vector);
+        return;
+    }
 
-    // Init the state machine and our temp variables
-    clear();
+    // An unchanged file (same content hash and size) is never parsed twice.
+    rgb_hash aHash;
+    uint64_t hash_value, file_size;
+    aHash.hash_file(in_file, hash_value, file_size);
+
+    rgb_node_columns columns;
+    if (node_cache->lookup(hash_value, file_size, columns))
+    {
+        columns.to_nodes(rgb_list_vector);
+        return;
+    }
 
+    parse_nodes(in_file, rgb_list_vector);
+    columns.assign(rgb_list_vector);
+    node_cache->store(hash_value, file_size, columns);
+}
+
+void rgb_extract::parse_nodes(string const &in_file, vector<rgb_node> &rgb_list_vector)
+{
     // Parse the file.
     //  - Verify its a VRML file
     //  - Seek the node name
@@ -54,10 +81,11 @@ void rgb_extract::extract_nodes(string const &in_file, vector<rgb_node> &rgb_lis
     //      - seek the rgb color node keyword
     //      - grab the three RGB colors
     // 
+    open_stream(in_file);
 
-    string aWord;
-    while (input_file.read_word(aWord)) {
-        process(aWord);
+    rgb_node aNode;
+    while (next_node(aNode)) {
+        rgb_list.push_back(aNode);
     }
 
 #if 0
@@ -82,8 +110,54 @@ void rgb_extract::extract_nodes(string const &in_file, vector<rgb_node> &rgb_lis
     rgb_list_vector = rgb_list;
 
     // Close the opened input file.
-    input_file.close(); 
+    close_stream();
+}
 
+void rgb_extract::open_stream(string const &in_file)
+{
+    // Need to allocate a fileIO object?
+    if (!srcFileIO)
+    {
+        srcFileIO = new rgb_fileio();
+    }
+
+    // Object created?  
+    if (!srcFileIO)
+    {
+        // Unable to allocate the rgb_fileio object.  This is an error.
+        aLogger->throw_exception(ENUM_UNABLE_TO_ALLOCATE_FILEIO,
+            "Unable to allocate rgb_fileio object.", 
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    // This will throw an exception if it cannot open the source file.
+    srcFileIO->clear();
+    srcFileIO->open(in_file);
+
+    // Init the state machine and our temp variables
+    clear();
+    in_file_name = in_file;
+}
+
+bool rgb_extract::next_node(rgb_node &aNode)
+{
+    // Feed words to the state machine until STATE_get_BLUE completes a node
+    //  or the file runs out.
+    string aWord;
+    while (srcFileIO->read_word(aWord)) {
+        process(aWord);
+        if (node_ready) {
+            node_ready = false;
+            aNode = temp_node;
+            return true;
+        }
+    }
+    return false;
+}
+
+void rgb_extract::close_stream()
+{
+    if (srcFileIO) srcFileIO->clear();
 }
 
 void rgb_extract::extract(string const &file_name, string const &rgb_node_file_name) 
@@ -93,6 +167,8 @@ void rgb_extract::extract(string const &file_name, string const &rgb_node_file_n
 
     // aVector should have some nodes.  Format and write them to an output node file.
     rgb_configio configIO;
+    configIO.set_timestamp(config_timestamp);
+    configIO.set_palette(config_palette);
     string temp_node_file_name;
     if (rgb_node_file_name == "")
     {
@@ -105,24 +181,176 @@ void rgb_extract::extract(string const &file_name, string const &rgb_node_file_n
     configIO.write_node_config_file(aVector, file_name, temp_node_file_name);
 }
 
-bool rgb_extract::verify(string const &file_name, string const &rgb_node_file_name)
+void rgb_extract::extract_config(string const &file_name, string &aNodeConfig)
 {
-    vector<rgb_node> source_file_rgb_nodes;
-    vector<rgb_node> config_file_rgb_nodes;
-    extract_nodes(file_name, source_file_rgb_nodes);
+    vector<rgb_node> aVector;
+    extract_nodes(file_name, aVector);
 
     rgb_configio configIO;
-    configIO.parse_node_config(rgb_node_file_name, config_file_rgb_nodes);
+    configIO.set_timestamp(config_timestamp);
+    configIO.set_palette(config_palette);
+    configIO.create_node_config(aVector, file_name, aNodeConfig);
+}
 
-    // Extracted RGB nodes from both the source file and the 
-    //  config file. 
+void rgb_extract::extract_binary(string const &file_name, string const &rgb_binary_file_name)
+{
+    vector<rgb_node> aVector;
+    extract_nodes(file_name, aVector);
 
-    // Determine if they are equal
-    if (source_file_rgb_nodes == config_file_rgb_nodes)
+    // aVector should have some nodes.  Write them to a binary node file.
+    rgb_binaryio binaryIO;
+    string temp_binary_file_name;
+    if (rgb_binary_file_name == "")
     {
-        return true;
+        temp_binary_file_name = file_name + CONST_STRING_DEFAULT_RGB_BINARY_FILE_EXTENTION;
+    }
+    else {
+        temp_binary_file_name = rgb_binary_file_name;
+    }
+
+    binaryIO.write_node_binary_file(aVector, file_name, temp_binary_file_name);
+}
+
+bool rgb_extract::verify(string const &file_name, string const &rgb_node_file_name)
+{
+    vector<unsigned int> mismatches;
+    return verify(file_name, rgb_node_file_name, mismatches, ENUM_VERIFY_FAST_FAIL);
+}
+
+bool rgb_extract::verify(string const &file_name, string const &rgb_node_file_name,
+    vector<unsigned int> &mismatches,
+    enum RGB_VERIFY_MODE mode)
+{
+    // Load the config file once up front.
+    rgb_config_cache configs;
+    return verify(file_name, *configs.get(rgb_node_file_name), mismatches, mode);
+}
+
+bool rgb_extract::verify(string const &file_name, rgb_node_table const &config_table,
+    vector<unsigned int> &mismatches,
+    enum RGB_VERIFY_MODE mode)
+{
+    mismatches.clear();
+
+    unsigned int index = 0;
+    uint64_t hash_value = 0, file_size = 0;
+    bool cached = false;
+    if (node_cache)
+    {
+        // A cached file is compared in one block without parsing it.  The
+        //  hash reads the whole file, but a miss is still parsed below and
+        //  stops at the first mismatch.
+        rgb_hash aHash;
+        aHash.hash_file(file_name, hash_value, file_size);
+
+        rgb_node_columns source_columns;
+        if (node_cache->lookup(hash_value, file_size, source_columns))
+        {
+            compare_block(source_columns, index, config_table, mismatches, mode);
+            index = source_columns.size();
+            cached = true;
+        }
+    }
+
+    if (!cached)
+    {
+        // Walk the source file.  Nodes are gathered into small blocks so 
+        //  the colors can be compared a column at a time.  With a cache
+        //  they are also kept, to be stored if the whole file is read.
+        open_stream(file_name);
+
+        rgb_node_columns block;
+        rgb_node_columns source_columns;
+        rgb_node aNode;
+        bool more = true;
+        while (more) {
+            more = next_node(aNode);
+            if (more) {
+                block.name.push_back(aNode.get_name());
+                block.red.push_back(aNode.get_red());
+                block.green.push_back(aNode.get_green());
+                block.blue.push_back(aNode.get_blue());
+                if (node_cache) {
+                    source_columns.name.push_back(aNode.get_name());
+                    source_columns.red.push_back(aNode.get_red());
+                    source_columns.green.push_back(aNode.get_green());
+                    source_columns.blue.push_back(aNode.get_blue());
+                }
+                if (block.size() < CONST_VERIFY_BLOCK_SIZE) continue;
+            }
+
+            compare_block(block, index, config_table, mismatches, mode);
+            index += block.size();
+            block.clear();
+
+            if ((mode == ENUM_VERIFY_FAST_FAIL) && !mismatches.empty()) {
+                // No need to read the rest of the file.  Part of a file
+                //  is not cached.
+                close_stream();
+                return false;
+            }
+        }
+        close_stream();
+
+        if (index == 0) 
+        {
+            // No RGB nodes extracted ... this is an error.
+            aLogger->throw_exception(ENUM_NO_RGB_VALUES_FOUND, 
+                "No rgb nodes were extracted from \"" + file_name
+                + "\".  Please check your input file.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+
+        if (node_cache) {
+            node_cache->store(hash_value, file_size, source_columns);
+        }
+    }
+
+    if ((mode == ENUM_VERIFY_FAST_FAIL) && !mismatches.empty()) {
+        return false;
+    }
+
+    // Config nodes left over are missing from the source file.
+    for (; index < config_table.size(); index++) {
+        mismatches.push_back(index);
+        if (mode == ENUM_VERIFY_FAST_FAIL) break;
+    }
+
+    return mismatches.empty();
+}
+
+void rgb_extract::compare_block(rgb_node_columns const &block, unsigned int index,
+    rgb_node_table const &config_table,
+    vector<unsigned int> &mismatches,
+    enum RGB_VERIFY_MODE mode)
+{
+    // Compare the block against the matching range of config nodes.
+    size_t count = block.size();
+    size_t in_config = 0;
+    if (index < config_table.size()) {
+        in_config = config_table.size() - index;
+        if (in_config > count) in_config = count;
+    }
+
+    vector<unsigned int> block_mismatches;
+    if (in_config > 0) {
+        comparator.compare(block, 0, config_table.red_column() + index,
+            config_table.green_column() + index, config_table.blue_column() + index,
+            in_config, block_mismatches, (mode == ENUM_VERIFY_FAST_FAIL));
+    }
+    for (unsigned int jj = 0; jj < block_mismatches.size(); jj++) {
+        mismatches.push_back(index + block_mismatches[jj]);
+    }
+
+    // Nodes past the end of the config don't match anything.
+    for (size_t jj = in_config; jj < count; jj++) {
+        mismatches.push_back(index + jj);
+        if (mode == ENUM_VERIFY_FAST_FAIL) break;
+    }
+
+    if ((mode == ENUM_VERIFY_FAST_FAIL) && (mismatches.size() > 1)) {
+        mismatches.resize(1);
     }
-    return false;
 }
 
 void rgb_extract::STATE_verify_VRML(const string &aWord)
@@ -195,7 +423,7 @@ void rgb_extract::STATE_get_GREEN(const string &aWord)
 void rgb_extract::STATE_get_BLUE(const string &aWord)
 {
     temp_node.set_blue(atof(aWord.c_str()));
-    rgb_list.push_back(temp_node); // Store the extracted RGB node in the vector.
+    node_ready = true; // next_node() hands the completed RGB node out.
     TRAN((STATE)&rgb_extract::STATE_seek_Transform); // Go back to seeking the node name.
 }
 
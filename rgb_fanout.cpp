@@ -0,0 +1,273 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_fanout.cpp
+##  This file defines the methods used to write many color variants of one
+##   VRML file.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_fanout_h__
+#include "include/rgb_fanout.h"
+#endif
+
+#ifndef __rgb_replace_h__
+#include "include/rgb_replace.h"
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+unsigned int rgb_fanout::worker_count() const
+{
+    if (threads > 0) return threads;
+    unsigned int cores = std::thread::hardware_concurrency();
+    return (cores > 0) ? cores : 1;
+}
+
+void rgb_fanout::open(string const &rgb_file)
+{
+    clear();
+    source_file = rgb_file;
+
+    if (!rgb_plan::map_file(rgb_file, mapping))
+    {
+        // Let replace() report what is wrong with the file.
+        ifstream test(rgb_file.c_str());
+        if (!test.is_open())
+        {
+            aLogger->throw_exception(ENUM_UNABLE_TO_OPEN_SOURCE,
+                "Unable to open input file \"" + rgb_file + "\".",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+        mapping.close();
+        return;
+    }
+
+    uint64_t fingerprint = 0;
+    scanned = rgb_plan::scan(mapping.data(), mapping.size(), def_offset, spans, fingerprint);
+    if (!scanned)
+    {
+        mapping.close();
+        spans.clear();
+        return;
+    }
+
+    source_nodes.reserve(spans.size());
+    for (unsigned int ii = 0; ii < spans.size(); ii++) {
+        source_nodes.push_back(rgb_plan::span_node(mapping.data(), spans[ii]));
+    }
+}
+
+void rgb_fanout::add(rgb_node_table_ptr config_table, string const &rgb_config_file,
+    string const &output_file)
+{
+    rgb_variant temp;
+    temp.config_file = rgb_config_file;
+    temp.output_file = output_file;
+    temp.config_table = config_table;
+    temp.changed = 0;
+    variants.push_back(temp);
+}
+
+long rgb_fanout::target(rgb_variant const &aVariant, unsigned int position) const
+{
+    rgb_node_table const &aTable = *aVariant.config_table;
+    if (!keyed) {
+        return (position < aTable.size()) ? (long)position : CONST_NODE_INDEX_NOT_FOUND;
+    }
+    return aTable.find(spans[position].name);
+}
+
+void rgb_fanout::prepare(rgb_variant &aVariant)
+{
+    // Same test as replace(): the file after the change against the
+    //  file now.  A positional config of another length always differs.
+    aVariant.changed = 0;
+    for (unsigned int ii = 0; ii < spans.size(); ii++)
+    {
+        long found = target(aVariant, ii);
+        if (found == CONST_NODE_INDEX_NOT_FOUND) continue;
+
+        rgb_node_table const &aTable = *aVariant.config_table;
+        if ((aTable.red(found) != source_nodes[ii].get_red()) ||
+            (aTable.green(found) != source_nodes[ii].get_green()) ||
+            (aTable.blue(found) != source_nodes[ii].get_blue()))
+        {
+            aVariant.changed++;
+        }
+    }
+
+    if ((aVariant.changed == 0) &&
+        (keyed || (aVariant.config_table->size() == source_nodes.size())))
+    {
+        aLogger->throw_exception(ENUM_RGB_NODES_MATCH,
+            "RGB nodes in \"" + source_file + "\" match the RGB nodes "
+            + "in \"" + aVariant.config_file + "\".  Nothing to do.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    // The history block is written in the same layout as the config.
+    int layout = aVariant.config_table->palette ? 1 : 0;
+    if (history[layout].empty())
+    {
+        rgb_configio cnfgFileIO;
+        cnfgFileIO.set_timestamp(config_timestamp);
+        cnfgFileIO.set_palette(aVariant.config_table->palette);
+        cnfgFileIO.create_node_config(source_nodes, source_file, history[layout]);
+    }
+}
+
+void rgb_fanout::write_variant(rgb_variant const &aVariant, write_failure &aFailure) const
+{
+    // Written to a temp file and renamed, as rgb_fileio does.
+    string temp_name = aVariant.output_file + CONST_STRING_DEFAULT_TEMP_FILE_EXTENTION;
+    ofstream out(temp_name.c_str(), ios::out | ios::binary);
+    if (!out.is_open())
+    {
+        aFailure.failed = true;
+        aFailure.code = ENUM_UNABLE_TO_OPEN_TEMP;
+        aFailure.detail = "Unable to open temp file \"" + temp_name + "\".";
+        return;
+    }
+
+    const char *buffer = mapping.data();
+    out.write(buffer, def_offset);
+    out << history[aVariant.config_table->palette ? 1 : 0];
+
+    size_t copied = def_offset;
+    for (unsigned int ii = 0; ii < spans.size(); ii++)
+    {
+        long found = target(aVariant, ii);
+        if (found == CONST_NODE_INDEX_NOT_FOUND) continue;
+
+        // Same formatting as the values written by rgb_replace.
+        rgb_node_table const &aTable = *aVariant.config_table;
+        float colors[3] = { aTable.red(found), aTable.green(found), aTable.blue(found) };
+        for (int color = 0; color < 3; color++)
+        {
+            out.write(buffer + copied, spans[ii].begin[color] - copied);
+            out << colors[color];
+            copied = spans[ii].end[color];
+        }
+    }
+    out.write(buffer + copied, mapping.size() - copied);
+    out.close();
+
+    if (out.fail())
+    {
+        aFailure.failed = true;
+        aFailure.code = ENUM_UNABLE_TO_WRITE_SOURCE;
+        aFailure.detail = "Unable to write temp file \"" + temp_name + "\".";
+        remove(temp_name.c_str());
+        return;
+    }
+    if (rename(temp_name.c_str(), aVariant.output_file.c_str()) != 0)
+    {
+        aFailure.failed = true;
+        aFailure.code = ENUM_UNABLE_TO_RENAME_TEMP;
+        aFailure.detail = "Unable to rename \"" + temp_name + "\" to \"" +
+            aVariant.output_file + "\".";
+        remove(temp_name.c_str());
+    }
+}
+
+void rgb_fanout::write()
+{
+    if (!scanned)
+    {
+        // A layout the scan does not handle: copy and replace, one
+        //  variant at a time.
+        for (unsigned int ii = 0; ii < variants.size(); ii++)
+        {
+            rgb_variant &aVariant = variants[ii];
+            try
+            {
+                {
+                    ifstream in(source_file.c_str(), ios::in | ios::binary);
+                    ofstream out(aVariant.output_file.c_str(), ios::out | ios::binary);
+                    out << in.rdbuf();
+                }
+                rgb_replace aReplaceObj;
+                aReplaceObj.set_keyed(keyed);
+                aReplaceObj.set_timestamp(config_timestamp);
+                aReplaceObj.replace(aVariant.output_file, *aVariant.config_table,
+                    aVariant.config_file);
+                aVariant.changed = aReplaceObj.plan.size();
+            }
+            catch (ErrException &e)
+            {
+                aVariant.error = e.what();
+                remove(aVariant.output_file.c_str());
+            }
+        }
+        return;
+    }
+
+    // Everything that needs the logger happens here, before the threads.
+    for (unsigned int ii = 0; ii < variants.size(); ii++)
+    {
+        try {
+            prepare(variants[ii]);
+        } catch (ErrException &e) {
+            variants[ii].error = e.what();
+        }
+    }
+
+    // Each worker takes the next variant until none are left.
+    vector<write_failure> failures(variants.size());
+    std::atomic<size_t> next(0);
+    auto work = [this, &next, &failures]() {
+        size_t ii;
+        while ((ii = next++) < variants.size()) {
+            failures[ii].failed = false;
+            if (variants[ii].error.empty()) write_variant(variants[ii], failures[ii]);
+        }
+    };
+
+    unsigned int workers = worker_count();
+    if (workers > variants.size()) workers = variants.size();
+    if (workers <= 1) {
+        work();
+    } else {
+        vector<std::thread> pool;
+        for (unsigned int tt = 0; tt < workers; tt++) {
+            pool.push_back(std::thread(work));
+        }
+        for (unsigned int tt = 0; tt < workers; tt++) {
+            pool[tt].join();
+        }
+    }
+
+    for (unsigned int ii = 0; ii < variants.size(); ii++)
+    {
+        if (!failures[ii].failed) continue;
+        try {
+            aLogger->throw_exception(failures[ii].code, failures[ii].detail,
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        } catch (ErrException &e) {
+            variants[ii].error = e.what();
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_file_list.cpp
+##  This file defines the methods used to read a list of files.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_file_list_h__
+#include "include/rgb_file_list.h"
+#endif
+
+#include <iostream>
+#include <sys/stat.h>
+
+void rgb_file_list::open(string const &file_name)
+{
+    clear();
+    if (file_name == "-")
+    {
+        input = &cin;
+        return;
+    }
+
+    list_file.open(file_name.c_str(), ios::in | ios::binary);
+    if (!list_file.is_open())
+    {
+        aLogger->throw_exception(ENUM_FILE_OR_DIRECTORY_NOT_FOUND,
+            "Unable to open the file list \"" + file_name + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    input = &list_file;
+}
+
+bool rgb_file_list::read_record(string &aRecord)
+{
+    aRecord.clear();
+    streambuf *aBuffer = input->rdbuf();
+    for (;;)
+    {
+        int cc = aBuffer->sbumpc();
+        if (cc == streambuf::traits_type::eof()) break;
+        if ((cc == separator) || ((separator < 0) && ((cc == '\n') || (cc == '\0'))))
+        {
+            separator = cc;
+            return true;
+        }
+        aRecord += (char)cc;
+    }
+
+    // The last record need not be terminated.
+    return !aRecord.empty();
+}
+
+bool rgb_file_list::next(string &aPath, string &aConfig, uint64_t &aSize)
+{
+    if (input == NULL) return false;
+
+    string aRecord;
+    while (read_record(aRecord))
+    {
+        if ((separator != '\0') && !aRecord.empty() &&
+            (aRecord[aRecord.size() - 1] == '\r')) {
+            aRecord.erase(aRecord.size() - 1);
+        }
+        if (aRecord.empty()) continue;
+        records++;
+
+        size_t tab = aRecord.find('\t');
+        aPath = aRecord.substr(0, tab);
+        aConfig = (tab == string::npos) ? string() : aRecord.substr(tab + 1);
+
+        // Only the listed files are looked at, one stat() each.
+        struct stat info;
+        if ((stat(aPath.c_str(), &info) != 0) || !S_ISREG(info.st_mode))
+        {
+            missing++;
+            continue;
+        }
+        aSize = info.st_size;
+        return true;
+    }
+    return false;
+}
+
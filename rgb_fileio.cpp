@@ -140,6 +140,19 @@ void rgb_fileio::write(char const &A)
     }
 }
 
+void rgb_fileio::write(const char *A, size_t length)
+{
+    // Will write length chars to the temp file.
+    //  Fails if a temp file was not created at open()
+    if (!temp_file_opened) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_SOURCE,
+            "Unable to write.  Temp file was not created at open().", 
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    } else {
+        temp_file_stream.write(A, length);
+    }
+}
+
 void rgb_fileio::overwrite()
 {   
     // Moves the original file to a bak status.
@@ -200,4 +213,21 @@ void rgb_fileio::erase()
     }
 }
 
-
+bool rgb_fileio::is_vrml_header(string const &file_name)
+{
+    ifstream aFile(file_name.c_str(), ios::in | ios::binary);
+    if (!aFile.is_open()) return false;
+
+    char header[CONST_VRML_HEADER_SNIFF_SIZE];
+    aFile.read(header, sizeof(header));
+    size_t count = aFile.gcount();
+
+    // The header must be followed by whitespace or the end of the file.
+    if (count < CONST_STRING_VRML_HEADER.size()) return false;
+    if (CONST_STRING_VRML_HEADER.compare(0, CONST_STRING_VRML_HEADER.size(),
+            header, CONST_STRING_VRML_HEADER.size()) != 0) return false;
+    if (count > CONST_STRING_VRML_HEADER.size()) {
+        return isspace(header[CONST_STRING_VRML_HEADER.size()]) != 0;
+    }
+    return true;
+}
@@ -0,0 +1,207 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_hash.cpp
+##  This file defines the XXH64 content hash.  The input is always read as
+##   little-endian so a hash is the same on every host.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_hash_h__
+#include "include/rgb_hash.h"
+#endif
+
+#ifndef __rgb_binaryio_h__
+#include "include/rgb_binaryio.h"
+#endif
+
+#include <cstring>
+
+static const uint64_t PRIME64_1 = 11400714785074694791ULL;
+static const uint64_t PRIME64_2 = 14029467366897019727ULL;
+static const uint64_t PRIME64_3 =  1609587929392839161ULL;
+static const uint64_t PRIME64_4 =  9650029242287828579ULL;
+static const uint64_t PRIME64_5 =  2870177450012600261ULL;
+
+static uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    acc *= PRIME64_1;
+    return acc;
+}
+
+static uint64_t xxh_merge_round(uint64_t acc, uint64_t val)
+{
+    val = xxh_round(0, val);
+    acc ^= val;
+    acc = acc * PRIME64_1 + PRIME64_4;
+    return acc;
+}
+
+void rgb_hash::clear(uint64_t aSeed)
+{
+    seed = aSeed;
+    v1 = seed + PRIME64_1 + PRIME64_2;
+    v2 = seed + PRIME64_2;
+    v3 = seed;
+    v4 = seed - PRIME64_1;
+    total_length = 0;
+    pending_size = 0;
+}
+
+void rgb_hash::update(const void *data, size_t length)
+{
+    const char *p = (const char *)data;
+    const char *end = p + length;
+    total_length += length;
+
+    // Finish a stripe left over from the last update.
+    if (pending_size > 0)
+    {
+        size_t fill = 32 - pending_size;
+        if (fill > length) fill = length;
+        memcpy(pending + pending_size, p, fill);
+        pending_size += fill;
+        p += fill;
+
+        if (pending_size < 32) return;
+
+        const char *q = (const char *)pending;
+        v1 = xxh_round(v1, rgb_binaryio::get_u64(q));
+        v2 = xxh_round(v2, rgb_binaryio::get_u64(q + 8));
+        v3 = xxh_round(v3, rgb_binaryio::get_u64(q + 16));
+        v4 = xxh_round(v4, rgb_binaryio::get_u64(q + 24));
+        pending_size = 0;
+    }
+
+    // Whole 32 byte stripes.
+    while (p + 32 <= end)
+    {
+        v1 = xxh_round(v1, rgb_binaryio::get_u64(p));
+        v2 = xxh_round(v2, rgb_binaryio::get_u64(p + 8));
+        v3 = xxh_round(v3, rgb_binaryio::get_u64(p + 16));
+        v4 = xxh_round(v4, rgb_binaryio::get_u64(p + 24));
+        p += 32;
+    }
+
+    // Keep the tail for the next update or the digest.
+    if (p < end)
+    {
+        memcpy(pending, p, end - p);
+        pending_size = end - p;
+    }
+}
+
+uint64_t rgb_hash::digest() const
+{
+    uint64_t h;
+
+    if (total_length >= 32)
+    {
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh_merge_round(h, v1);
+        h = xxh_merge_round(h, v2);
+        h = xxh_merge_round(h, v3);
+        h = xxh_merge_round(h, v4);
+    }
+    else
+    {
+        h = seed + PRIME64_5;
+    }
+
+    h += total_length;
+
+    const char *p = (const char *)pending;
+    const char *end = p + pending_size;
+    while (p + 8 <= end)
+    {
+        h ^= xxh_round(0, rgb_binaryio::get_u64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= (uint64_t)rgb_binaryio::get_u32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end)
+    {
+        h ^= (uint64_t)(unsigned char)(*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t rgb_hash::hash(const void *data, size_t length, uint64_t seed)
+{
+    rgb_hash aHash(seed);
+    aHash.update(data, length);
+    return aHash.digest();
+}
+
+void rgb_hash::hash_file(string const &file_name, uint64_t &hash_value, uint64_t &file_size)
+{
+    ifstream in_file(file_name.c_str(), ios::in | ios::binary);
+    if (!in_file.is_open())
+    {
+        aLogger->throw_exception(ENUM_UNABLE_TO_OPEN_SOURCE,
+            "Unable to open input file \"" + file_name + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    clear(seed);
+
+    char buffer[65536];
+    while (in_file)
+    {
+        in_file.read(buffer, sizeof(buffer));
+        if (in_file.gcount() > 0)
+        {
+            update(buffer, in_file.gcount());
+        }
+    }
+
+    if (in_file.bad())
+    {
+        aLogger->throw_exception(ENUM_UNABLE_TO_READ_SOURCE,
+            "Unable to read input file \"" + file_name + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    hash_value = digest();
+    file_size = total_length;
+}
@@ -0,0 +1,238 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_manifest.cpp
+##  This file defines the methods used to keep the manifest of processed
+##   files.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_manifest_h__
+#include "include/rgb_manifest.h"
+#endif
+
+#ifndef __rgb_binaryio_h__
+#include "include/rgb_binaryio.h"
+#endif
+
+#ifndef __rgb_hash_h__
+#include "include/rgb_hash.h"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <time.h>
+
+// Fixed part of the manifest file header and of each entry.
+static const uint64_t MANIFEST_HEADER_SIZE = 24;
+static const uint64_t MANIFEST_ENTRY_HEADER_SIZE = 44;
+
+static int64_t mtime_of(struct stat const &info)
+{
+    return (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+int64_t rgb_manifest::now()
+{
+    struct timespec aTime;
+    clock_gettime(CLOCK_REALTIME, &aTime);
+    return (int64_t)aTime.tv_sec * 1000000000 + aTime.tv_nsec;
+}
+
+void rgb_manifest::open(string const &file_name)
+{
+    clear();
+    manifest_file = file_name;
+    run_started = now();
+
+    ifstream in_file(file_name.c_str(), ios::in | ios::binary);
+    if (!in_file.is_open()) {
+        // No manifest yet.  It will be created by save().
+        return;
+    }
+
+    vector<char> buffer((istreambuf_iterator<char>(in_file)), istreambuf_iterator<char>());
+    const char *data = buffer.empty() ? NULL : &buffer[0];
+    uint64_t size = buffer.size();
+
+    if ((size < MANIFEST_HEADER_SIZE) ||
+        (memcmp(data, CONST_STRING_MANIFEST_MAGIC.data(), 8) != 0) ||
+        (rgb_binaryio::get_u32(data + 8) != CONST_MANIFEST_CURRENT_VERSION))
+    {
+        // Not a manifest we understand.  Start over; save() replaces it.
+        dirty = true;
+        return;
+    }
+
+    uint64_t count = rgb_binaryio::get_u64(data + 16);
+    uint64_t position = MANIFEST_HEADER_SIZE;
+
+    for (uint64_t ii = 0; ii < count; ii++)
+    {
+        if (size - position < MANIFEST_ENTRY_HEADER_SIZE) {
+            // Keep what was read before the damage and rewrite the file.
+            dirty = true;
+            break;
+        }
+
+        manifest_entry entry;
+        entry.size = rgb_binaryio::get_u64(data + position);
+        entry.mtime = (int64_t)rgb_binaryio::get_u64(data + position + 8);
+        entry.checked = (int64_t)rgb_binaryio::get_u64(data + position + 16);
+        entry.content_hash = rgb_binaryio::get_u64(data + position + 24);
+        entry.config_hash = rgb_binaryio::get_u64(data + position + 32);
+        uint32_t name_size = rgb_binaryio::get_u32(data + position + 40);
+        position += MANIFEST_ENTRY_HEADER_SIZE;
+
+        if (size - position < name_size) {
+            dirty = true;
+            break;
+        }
+        entries[string(data + position, name_size)] = entry;
+        position += name_size;
+    }
+}
+
+bool rgb_manifest::is_unchanged(string const &file_name, uint64_t config_hash)
+{
+    struct stat info;
+    if (stat(file_name.c_str(), &info) != 0) return false;
+
+    manifest_entry entry;
+    {
+        lock_guard<mutex> lock(entries_mutex);
+        map<string, manifest_entry>::const_iterator it = entries.find(file_name);
+        if ((it == entries.end()) || (it->second.config_hash != config_hash)) return false;
+        entry = it->second;
+    }
+    if ((uint64_t)info.st_size != entry.size) return false;
+
+    int64_t mtime = mtime_of(info);
+    if ((mtime == entry.mtime) && (mtime < entry.checked - CONST_MANIFEST_MTIME_SLACK_NS))
+    {
+        lock_guard<mutex> lock(entries_mutex);
+        unchanged++;
+        return true;
+    }
+
+    // Touched, copied or too recent: the content decides.
+    uint64_t hash_value;
+    uint64_t file_size;
+    try {
+        rgb_hash aHash;
+        aHash.hash_file(file_name, hash_value, file_size);
+    } catch (ErrException &) {
+        return false;
+    }
+    if ((hash_value != entry.content_hash) || (file_size != entry.size)) return false;
+
+    lock_guard<mutex> lock(entries_mutex);
+    entry.mtime = mtime;
+    entry.checked = run_started;
+    entries[file_name] = entry;
+    dirty = true;
+    unchanged++;
+    hashed++;
+    return true;
+}
+
+void rgb_manifest::record(string const &file_name, uint64_t config_hash)
+{
+    // The mtime before the content, so a change in between shows up as a
+    //  different mtime next time.
+    struct stat info;
+    if (stat(file_name.c_str(), &info) != 0) return;
+
+    manifest_entry entry;
+    try {
+        rgb_hash aHash;
+        aHash.hash_file(file_name, entry.content_hash, entry.size);
+    } catch (ErrException &) {
+        // Not recorded; it is processed again next time.
+        return;
+    }
+    entry.mtime = mtime_of(info);
+    entry.checked = run_started;
+    entry.config_hash = config_hash;
+
+    lock_guard<mutex> lock(entries_mutex);
+    entries[file_name] = entry;
+    recorded++;
+    dirty = true;
+}
+
+void rgb_manifest::save()
+{
+    if (!dirty || manifest_file.empty()) return;
+
+    // Write a temp file and rename it so an interrupted run never leaves
+    //  a half written manifest behind.
+    string temp_file_name = manifest_file + CONST_STRING_DEFAULT_TEMP_FILE_EXTENTION;
+    ofstream out_file(temp_file_name.c_str(), ios::out | ios::trunc | ios::binary);
+    if (!out_file.is_open()) {
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to open manifest file \"" + temp_file_name + "\" for writing.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    char header[MANIFEST_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, CONST_STRING_MANIFEST_MAGIC.data(), 8);
+    rgb_binaryio::put_u32(header + 8, CONST_MANIFEST_CURRENT_VERSION);
+    rgb_binaryio::put_u64(header + 16, entries.size());
+    out_file.write(header, sizeof(header));
+
+    string record;
+    for (map<string, manifest_entry>::const_iterator it = entries.begin();
+        it != entries.end(); it++)
+    {
+        record.resize(MANIFEST_ENTRY_HEADER_SIZE + it->first.size());
+        char *p = &record[0];
+
+        rgb_binaryio::put_u64(p, it->second.size);
+        rgb_binaryio::put_u64(p + 8, (uint64_t)it->second.mtime);
+        rgb_binaryio::put_u64(p + 16, (uint64_t)it->second.checked);
+        rgb_binaryio::put_u64(p + 24, it->second.content_hash);
+        rgb_binaryio::put_u64(p + 32, it->second.config_hash);
+        rgb_binaryio::put_u32(p + 40, it->first.size());
+        memcpy(p + MANIFEST_ENTRY_HEADER_SIZE, it->first.data(), it->first.size());
+        out_file.write(record.data(), record.size());
+    }
+
+    out_file.close();
+    if (out_file.fail() || (rename(temp_file_name.c_str(), manifest_file.c_str()) != 0)) {
+        remove(temp_file_name.c_str());
+        aLogger->throw_exception(ENUM_UNABLE_TO_WRITE_CONFIG,
+            "Unable to write manifest file \"" + manifest_file + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    dirty = false;
+}
+
+void rgb_manifest::print_statistics(ostream &out) const
+{
+    out << "Incremental : " << unchanged << " unchanged (" << hashed << " by content), "
+        << recorded << " recorded, " << entries.size() << " entries" << endl;
+}
+
@@ -19,8 +19,8 @@
 ##   inside VRML V2.0 files.  (File extention WRL)
 ##
 ## Filename: rgb_node.cpp
-##  This file holds the "operator<<" for the rgb_node class and the 
-##   init values for the singleton.
+##  This file holds the "operator<<" for the rgb_node class, the 
+##   rgb_node_columns conversions and the init values for the singleton.
 ##
 ## Usage: 
 ##   -help  : Prints usage information
@@ -38,9 +38,40 @@ ostream& operator<<(ostream &out, const rgb_node &A)
     return out;
 }
 
+void rgb_node_columns::assign(vector<rgb_node> const &node_vector)
+{
+    clear();
+    name.reserve(node_vector.size());
+    red.reserve(node_vector.size());
+    green.reserve(node_vector.size());
+    blue.reserve(node_vector.size());
+
+    for (unsigned int ii = 0; ii < node_vector.size(); ii++) {
+        name.push_back(node_vector[ii].get_name());
+        red.push_back(node_vector[ii].get_red());
+        green.push_back(node_vector[ii].get_green());
+        blue.push_back(node_vector[ii].get_blue());
+    }
+}
+
+void rgb_node_columns::to_nodes(vector<rgb_node> &node_vector) const
+{
+    // NOTE the rgb_node setters will throw if a color is out of range.
+    node_vector.clear();
+    node_vector.reserve(size());
+
+    rgb_node temp;
+    for (unsigned int ii = 0; ii < size(); ii++) {
+        temp.set_name(name[ii]);
+        temp.set_red(red[ii]);
+        temp.set_green(green[ii]);
+        temp.set_blue(blue[ii]);
+        node_vector.push_back(temp);
+    }
+}
+
 // Init the singleton
-int LoggerLevel::_referenceCount = 0;  
-LoggerLevel* LoggerLevel::_instance = NULL;
+atomic<int> LoggerLevel::_referenceCount(0);
 
 
 
@@ -0,0 +1,95 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_node_index.cpp
+##  This file defines the methods of the node name hash index.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_node_index_h__
+#include "include/rgb_node_index.h"
+#endif
+
+#ifndef __rgb_hash_h__
+#include "include/rgb_hash.h"
+#endif
+
+void rgb_node_index::build(vector<rgb_node> const &node_vector)
+{
+    vector<string> node_names;
+    node_names.reserve(node_vector.size());
+    for (unsigned int ii = 0; ii < node_vector.size(); ii++) {
+        node_names.push_back(node_vector[ii].get_name());
+    }
+    build(node_names);
+}
+
+void rgb_node_index::build(vector<string> const &node_names)
+{
+    clear();
+
+    // Keep the table at most half full so probe runs stay short.
+    uint64_t capacity = 16;
+    while (capacity < node_names.size() * 2) capacity *= 2;
+
+    slot empty = { 0, 0 };
+    slots.assign(capacity, empty);
+    mask = capacity - 1;
+    names.reserve(node_names.size());
+
+    for (unsigned int ii = 0; ii < node_names.size(); ii++)
+    {
+        string const &aName = node_names[ii];
+        names.push_back(aName);
+
+        if (find(aName) != CONST_NODE_INDEX_NOT_FOUND) continue;
+
+        uint64_t hash = rgb_hash::hash(aName.data(), aName.size());
+        uint64_t position = hash & mask;
+        while (slots[position].position != 0) {
+            position = (position + 1) & mask;
+        }
+        slots[position].hash = hash;
+        slots[position].position = ii + 1;
+    }
+}
+
+long rgb_node_index::find(string const &aName) const
+{
+    if (slots.empty()) return CONST_NODE_INDEX_NOT_FOUND;
+
+    uint64_t hash = rgb_hash::hash(aName.data(), aName.size());
+    uint64_t position = hash & mask;
+
+    // Linear probe until an empty slot.
+    while (slots[position].position != 0)
+    {
+        if ((slots[position].hash == hash) &&
+            (names[slots[position].position - 1] == aName))
+        {
+            return slots[position].position - 1;
+        }
+        position = (position + 1) & mask;
+    }
+    return CONST_NODE_INDEX_NOT_FOUND;
+}
@@ -0,0 +1,372 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_plan.cpp
+##  This file defines the methods used to compile and apply replacement
+##   plans.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_plan_h__
+#include "include/rgb_plan.h"
+#endif
+
+#ifndef __rgb_configio_h__
+#include "include/rgb_configio.h"
+#endif
+
+#ifndef __rgb_fileio_h__
+#include "include/rgb_fileio.h"
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+void rgb_plan::add_name(rgb_hash &aHash, string const &aName)
+{
+    // The terminating zero keeps "AB" "C" apart from "A" "BC".
+    aHash.update(aName.c_str(), aName.size() + 1);
+}
+
+void rgb_plan::compile(rgb_node_table const &config_table, string const &rgb_config_file,
+    rgb_transform const *aTransform, rgb_remap const *aRemap, bool keyed)
+{
+    clear();
+    config_file = rgb_config_file;
+    palette = config_table.palette;
+
+    // The config is read in place.  Only a transform or a palette needs
+    //  its own copy of the nodes to work on.
+    targets.reserve(config_table.size());
+    for (size_t ii = 0; ii < config_table.size(); ii++) {
+        targets.push_back(config_table.node(ii));
+    }
+
+    // Same order as rgb_replace::adjust().
+    if (aTransform && aRemap)
+    {
+        vector<rgb_node> transformed;
+        aTransform->apply(targets, transformed);
+        aRemap->apply(transformed, targets);
+    }
+    else if (aTransform)
+    {
+        vector<rgb_node> transformed;
+        aTransform->apply(targets, transformed);
+        targets.swap(transformed);
+    }
+    else if (aRemap)
+    {
+        vector<rgb_node> remapped;
+        aRemap->apply(targets, remapped);
+        targets.swap(remapped);
+    }
+
+    // Keyed and positional replace agree on a matching file unless a
+    //  name is repeated; then keyed picks the first node of that name.
+    usable = true;
+    rgb_hash aHash;
+    for (unsigned int ii = 0; ii < targets.size(); ii++)
+    {
+        string const &aName = targets[ii].get_name();
+        if (keyed && (config_table.find(aName) != (long)ii)) {
+            usable = false;
+        }
+        names.push_back(aName);
+        add_name(aHash, aName);
+
+        // Same formatting as the values written by rgb_replace.
+        stringstream red, green, blue;
+        red << targets[ii].get_red();
+        green << targets[ii].get_green();
+        blue << targets[ii].get_blue();
+        values.push_back(red.str());
+        values.push_back(green.str());
+        values.push_back(blue.str());
+    }
+    fingerprint = aHash.digest();
+}
+
+bool rgb_plan::map_file(string const &file_name, rgb_mapped_file &mapping)
+{
+    try {
+        mapping.open(file_name);
+    } catch (ErrException &) {
+        return false;
+    }
+    if (mapping.size() == 0) return false;
+
+    return (memchr(mapping.data(), 0, mapping.size()) == NULL);
+}
+
+rgb_node rgb_plan::span_node(const char *buffer, color_span const &aSpan)
+{
+    rgb_node temp;
+    temp.set_name(aSpan.name);
+    temp.set_red(atof(span_text(buffer, aSpan, 0).c_str()));
+    temp.set_green(atof(span_text(buffer, aSpan, 1).c_str()));
+    temp.set_blue(atof(span_text(buffer, aSpan, 2).c_str()));
+    return temp;
+}
+
+bool rgb_plan::scan_range(const char *buffer, size_t begin, size_t end,
+    scan_state &state, vector<color_span> &spans)
+{
+    // Words end at a whitespace char, as in the rgb_replace states.  Two
+    //  whitespace chars in a row make an empty word.
+    size_t word_begin = begin;
+
+    for (size_t ii = begin; ii < end; ii++)
+    {
+        if (!isspace((unsigned char)buffer[ii])) continue;
+
+        const char *word = buffer + word_begin;
+        size_t word_size = ii - word_begin;
+        word_begin = ii + 1;
+
+        switch (state.step)
+        {
+        case HEADER_VRML:
+        case HEADER_VER:
+        case HEADER_CHARSET:
+        {
+            string const &required = (state.step == HEADER_VRML) ? CONST_STRING_VRML_KEYWORD :
+                (state.step == HEADER_VER) ? CONST_STRING_VRML_VER_KEYWORD :
+                CONST_STRING_VRML_CHARSET_KEYWORD;
+            if (required.compare(0, string::npos, word, word_size) != 0) return false;
+            state.step = (state.step == HEADER_VRML) ? HEADER_VER :
+                (state.step == HEADER_VER) ? HEADER_CHARSET : SEEK_DEF;
+            break;
+        }
+        case SEEK_DEF:
+            if (CONST_STRING_DEF_KEYWORD.compare(0, string::npos, word, word_size) == 0)
+            {
+                state.def_offset = ii - word_size;
+                state.step = SEEK_DIFFUSECOLOR;
+            }
+            break;
+        case SEEK_DIFFUSECOLOR:
+            if (CONST_STRING_DIFFUSECOLOR_KEYWORD.compare(0, string::npos, word, word_size) == 0)
+            {
+                state.aSpan.name = state.node_name;
+                if (!state.named) state.inherited++;
+                state.step = RED;
+            }
+            else if (CONST_STRING_TRANSFORM_KEYWORD.compare(0, string::npos, word, word_size) == 0)
+            {
+                state.node_name = state.last_word;
+                state.named = true;
+            }
+            else if (word_size)
+            {
+                state.last_word.assign(word, word_size);
+            }
+            break;
+        case RED:
+        case GREEN:
+        case BLUE:
+        {
+            // An empty value is left to replace() to deal with.
+            if (!word_size) return false;
+
+            int color = state.step - RED;
+            state.aSpan.begin[color] = ii - word_size;
+            state.aSpan.end[color] = ii;
+            if (state.step == BLUE)
+            {
+                spans.push_back(state.aSpan);
+                state.step = SEEK_DIFFUSECOLOR;
+            }
+            else
+            {
+                state.step = (state.step == RED) ? GREEN : BLUE;
+            }
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+bool rgb_plan::scan(const char *buffer, size_t buffer_size, size_t &def_offset,
+    vector<color_span> &spans, uint64_t &file_fingerprint, unsigned int threads)
+{
+    // Each chunk but the first starts at a "DEF" word and is scanned as if
+    //  the chunk before it ended between nodes.  That guess is checked
+    //  once all are done; if it was wrong the file is scanned in one go.
+    //  Colors found before the first Transform of a chunk get their node
+    //  name from the chunk before.
+    vector<size_t> starts(1, 0);
+    const char *buffer_end = buffer + buffer_size;
+    auto find_def = [&](size_t from) {
+        return (size_t)(search(buffer + from, buffer_end,
+            CONST_STRING_DEF_KEYWORD.begin(), CONST_STRING_DEF_KEYWORD.end()) - buffer);
+    };
+
+    size_t chunks = min<size_t>(threads, buffer_size / CONST_PLAN_CHUNK_SIZE);
+    for (size_t kk = 1; kk < chunks; kk++)
+    {
+        size_t from = max(starts.back() + 1, kk * (buffer_size / chunks));
+        size_t found = find_def(from);
+        while ((found != buffer_size) &&
+               !(isspace((unsigned char)buffer[found - 1]) &&
+                 (found + CONST_STRING_DEF_KEYWORD.size() < buffer_size) &&
+                 isspace((unsigned char)buffer[found + CONST_STRING_DEF_KEYWORD.size()])))
+        {
+            found = find_def(found + 1);
+        }
+        if (found == buffer_size) break;
+        starts.push_back(found);
+    }
+    starts.push_back(buffer_size);
+    chunks = starts.size() - 1;
+
+    vector<scan_state> states(chunks);
+    vector<vector<color_span> > found_spans(chunks);
+    unique_ptr<bool[]> scanned(new bool[chunks]);
+    for (size_t kk = 1; kk < chunks; kk++) {
+        states[kk].step = SEEK_DIFFUSECOLOR;
+    }
+
+    auto run = [&](size_t kk) {
+        scanned[kk] = scan_range(buffer, starts[kk], starts[kk + 1], states[kk], found_spans[kk]);
+    };
+    vector<thread> pool;
+    for (size_t kk = 1; kk < chunks; kk++) {
+        pool.push_back(thread(run, kk));
+    }
+    run(0);
+    for (size_t kk = 0; kk < pool.size(); kk++) {
+        pool[kk].join();
+    }
+
+    spans.clear();
+    for (size_t kk = 0; kk < chunks; kk++)
+    {
+        if ((kk > 0) && (states[kk - 1].step != SEEK_DIFFUSECOLOR)) {
+            // The guess was wrong.
+            return scan(buffer, buffer_size, def_offset, spans, file_fingerprint, 1);
+        }
+        if (!scanned[kk]) return false;
+
+        if (kk > 0)
+        {
+            for (size_t ii = 0; (ii < states[kk].inherited) && (ii < found_spans[kk].size()); ii++) {
+                found_spans[kk][ii].name = states[kk - 1].node_name;
+            }
+            if (!states[kk].named) states[kk].node_name = states[kk - 1].node_name;
+        }
+        spans.insert(spans.end(), found_spans[kk].begin(), found_spans[kk].end());
+        vector<color_span>().swap(found_spans[kk]);
+    }
+
+    rgb_hash aHash;
+    for (size_t ii = 0; ii < spans.size(); ii++) {
+        add_name(aHash, spans[ii].name);
+    }
+    def_offset = states[0].def_offset;
+    file_fingerprint = aHash.digest();
+    return (states[chunks - 1].step == SEEK_DIFFUSECOLOR);
+}
+
+bool rgb_plan::apply(string const &rgb_file, vector<rgb_patch> &patches,
+    bool dry_run, unsigned int aThreads) const
+{
+    patches.clear();
+    if (!usable) return false;
+
+    // The file is mapped, not read into memory.  The history config goes
+    //  before the first DEF and needs every color, so the file is scanned
+    //  first and written after.  The file is replaced by a rename, so the
+    //  mapping stays valid while it is written.
+    rgb_mapped_file mapping;
+    if (!map_file(rgb_file, mapping)) return false;
+    const char *buffer = mapping.data();
+    size_t buffer_size = mapping.size();
+
+    size_t def_offset = 0;
+    vector<color_span> spans;
+    uint64_t file_fingerprint = 0;
+    if (!scan(buffer, buffer_size, def_offset, spans, file_fingerprint, aThreads)) return false;
+    if ((spans.size() != targets.size()) || (file_fingerprint != fingerprint)) return false;
+
+    // The colors in the file now.
+    vector<rgb_node> source_node_vector;
+    source_node_vector.reserve(spans.size());
+    for (unsigned int ii = 0; ii < spans.size(); ii++)
+    {
+        color_span const &aSpan = spans[ii];
+        source_node_vector.push_back(span_node(buffer, aSpan));
+        if (source_node_vector.back() == targets[ii]) continue;
+
+        rgb_patch aPatch;
+        aPatch.index = ii;
+        aPatch.name = aSpan.name;
+        aPatch.offset = aSpan.begin[0];
+        aPatch.length = aSpan.end[2] - aSpan.begin[0];
+        aPatch.old_value = span_text(buffer, aSpan, 0) + " " +
+            span_text(buffer, aSpan, 1) + " " + span_text(buffer, aSpan, 2);
+        aPatch.new_value = values[ii * 3] + " " + values[ii * 3 + 1] + " " + values[ii * 3 + 2];
+        patches.push_back(aPatch);
+    }
+
+    if (patches.empty())
+    {
+        // Same as replace(): nothing to do is an error.
+        aLogger->throw_exception(ENUM_RGB_NODES_MATCH,
+            "RGB nodes in \"" + rgb_file + "\" match the RGB nodes "
+            + "in \"" + config_file + "\".  Nothing to do.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    if (dry_run) return true;
+
+    // The history config written by replace(), for rollback.
+    string existing_node_config;
+    rgb_configio cnfgFileIO;
+    cnfgFileIO.set_timestamp(config_timestamp);
+    cnfgFileIO.set_palette(palette);
+    cnfgFileIO.create_node_config(source_node_vector, rgb_file, existing_node_config);
+
+    rgb_fileio srcFileIO(rgb_file, true);
+    srcFileIO.write(buffer, def_offset);
+    srcFileIO.write(existing_node_config);
+
+    size_t copied = def_offset;
+    for (unsigned int ii = 0; ii < spans.size(); ii++)
+    {
+        for (int color = 0; color < 3; color++)
+        {
+            srcFileIO.write(buffer + copied, spans[ii].begin[color] - copied);
+            srcFileIO.write(values[ii * 3 + color]);
+            copied = spans[ii].end[color];
+        }
+    }
+    srcFileIO.write(buffer + copied, buffer_size - copied);
+
+    srcFileIO.close();
+    srcFileIO.overwrite();
+    return true;
+}
@@ -0,0 +1,382 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_reduce.cpp
+##  This file defines the methods used to reduce colors to a palette.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_reduce_h__
+#include "include/rgb_reduce.h"
+#endif
+
+#ifndef __rgb_remap_h__
+#include "include/rgb_remap.h"
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Distance of the padding centers.  Never the nearest.
+static const float FAR_CENTER = 1e18f;
+
+void rgb_reduce::add(float red, float green, float blue, uint64_t weight)
+{
+    color_key key;
+    memcpy(&key.bits[0], &red, sizeof(float));
+    memcpy(&key.bits[1], &green, sizeof(float));
+    memcpy(&key.bits[2], &blue, sizeof(float));
+    counts[key] += weight;
+    total += weight;
+}
+
+void rgb_reduce::add_file(string const &file_name)
+{
+    extractor.open_stream(file_name);
+    try {
+        rgb_node aNode;
+        while (extractor.next_node(aNode)) {
+            add(aNode.get_red(), aNode.get_green(), aNode.get_blue());
+        }
+    }
+    catch (...) {
+        extractor.close_stream();
+        throw;
+    }
+    extractor.close_stream();
+}
+
+unsigned int rgb_reduce::worker_count() const
+{
+    if (threads > 0) return threads;
+    unsigned int cores = std::thread::hardware_concurrency();
+    return (cores > 0) ? cores : 1;
+}
+
+void rgb_reduce::parallel_for(size_t count,
+    std::function<void(unsigned int, size_t, size_t)> const &work) const
+{
+    unsigned int workers = worker_count();
+    if (workers == 1) {
+        work(0, 0, count);
+        return;
+    }
+
+    vector<std::thread> pool;
+    for (unsigned int tt = 0; tt < workers; tt++) {
+        size_t begin = count * tt / workers;
+        size_t end = count * (tt + 1) / workers;
+        pool.push_back(std::thread(work, tt, begin, end));
+    }
+    for (unsigned int tt = 0; tt < workers; tt++) {
+        pool[tt].join();
+    }
+}
+
+void rgb_reduce::reduce(unsigned int aColors, vector<rgb_node> &palette)
+{
+    palette.clear();
+    iterations = 0;
+
+    if (counts.empty())
+    {
+        aLogger->throw_exception(ENUM_NO_RGB_VALUES_FOUND,
+            "No colors to reduce.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    if (aColors == 0)
+    {
+        aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+            "The palette needs at least one color.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    // Distinct colors as columns.
+    size_t count = counts.size();
+    vector<float> red(count), green(count), blue(count);
+    vector<double> weight(count);
+    size_t ii = 0;
+    for (unordered_map<color_key, uint64_t, color_key_hash>::const_iterator it = counts.begin();
+        it != counts.end(); it++, ii++)
+    {
+        memcpy(&red[ii], &it->first.bits[0], sizeof(float));
+        memcpy(&green[ii], &it->first.bits[1], sizeof(float));
+        memcpy(&blue[ii], &it->first.bits[2], sizeof(float));
+        weight[ii] = it->second;
+    }
+
+    // Hash map order is not repeatable across builds; sort for k-means++.
+    {
+        vector<size_t> order(count);
+        for (ii = 0; ii < count; ii++) order[ii] = ii;
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            if (red[a] != red[b]) return red[a] < red[b];
+            if (green[a] != green[b]) return green[a] < green[b];
+            return blue[a] < blue[b];
+        });
+        vector<float> r(count), g(count), b(count);
+        vector<double> w(count);
+        for (ii = 0; ii < count; ii++) {
+            r[ii] = red[order[ii]];
+            g[ii] = green[order[ii]];
+            b[ii] = blue[order[ii]];
+            w[ii] = weight[order[ii]];
+        }
+        red.swap(r);
+        green.swap(g);
+        blue.swap(b);
+        weight.swap(w);
+    }
+
+    if (count <= aColors)
+    {
+        // Nothing to reduce.
+        vector<size_t> order(count);
+        for (ii = 0; ii < count; ii++) order[ii] = ii;
+        stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return weight[a] > weight[b];
+        });
+        rgb_node temp;
+        for (ii = 0; ii < count; ii++) {
+            temp.set_name("color_" + to_string(ii));
+            temp.set_red(red[order[ii]]);
+            temp.set_green(green[order[ii]]);
+            temp.set_blue(blue[order[ii]]);
+            palette.push_back(temp);
+        }
+        return;
+    }
+
+    vector<float> L(count), A(count), B(count);
+    parallel_for(count, [&](unsigned int, size_t begin, size_t end) {
+        float lab[3];
+        for (size_t jj = begin; jj < end; jj++) {
+            rgb_remap::to_lab(red[jj], green[jj], blue[jj], lab);
+            L[jj] = lab[0];
+            A[jj] = lab[1];
+            B[jj] = lab[2];
+        }
+    });
+
+    // Centers as columns, padded to a multiple of four.
+    size_t padded = (aColors + 3) & ~(size_t)3;
+    vector<float> cL(padded, FAR_CENTER), cA(padded, FAR_CENTER), cB(padded, FAR_CENTER);
+
+    // k-means++: each next center is drawn with probability weight *
+    //  (distance to the nearest center so far)^2.
+    unsigned int workers = worker_count();
+    std::mt19937_64 random(CONST_REDUCE_SEED);
+    vector<double> nearest(count, HUGE_VAL);
+    vector<double> partial(workers);
+
+    double sum = 0.0;
+    for (ii = 0; ii < count; ii++) sum += weight[ii];
+    double pick = std::uniform_real_distribution<double>(0.0, sum)(random);
+    size_t chosen = 0;
+    for (ii = 0; ii < count; ii++) {
+        pick -= weight[ii];
+        if (pick < 0) { chosen = ii; break; }
+        chosen = ii;
+    }
+
+    for (unsigned int cc = 0; cc < aColors; cc++)
+    {
+        cL[cc] = L[chosen];
+        cA[cc] = A[chosen];
+        cB[cc] = B[chosen];
+        if (cc + 1 == aColors) break;
+
+        parallel_for(count, [&](unsigned int tt, size_t begin, size_t end) {
+            double share = 0.0;
+            for (size_t jj = begin; jj < end; jj++) {
+                double dl = L[jj] - cL[cc];
+                double da = A[jj] - cA[cc];
+                double db = B[jj] - cB[cc];
+                double distance = dl * dl + da * da + db * db;
+                if (distance < nearest[jj]) nearest[jj] = distance;
+                share += weight[jj] * nearest[jj];
+            }
+            partial[tt] = share;
+        });
+
+        sum = 0.0;
+        for (unsigned int tt = 0; tt < workers; tt++) sum += partial[tt];
+        if (sum <= 0.0)
+        {
+            // Every color is already a center.
+            aColors = cc + 1;
+            break;
+        }
+
+        // Find the worker share holding the pick, then the color in it.
+        pick = std::uniform_real_distribution<double>(0.0, sum)(random);
+        unsigned int tt = 0;
+        while ((tt + 1 < workers) && (pick >= partial[tt])) {
+            pick -= partial[tt];
+            tt++;
+        }
+        size_t begin = count * tt / workers;
+        size_t end = count * (tt + 1) / workers;
+        chosen = begin;
+        for (ii = begin; ii < end; ii++) {
+            double share = weight[ii] * nearest[ii];
+            if (share > 0) chosen = ii;
+            pick -= share;
+            if ((pick < 0) && (share > 0)) break;
+        }
+    }
+    for (size_t cc = aColors; cc < padded; cc++) {
+        cL[cc] = cA[cc] = cB[cc] = FAR_CENTER;
+    }
+
+    // Lloyd steps until no color changes center.
+    vector<unsigned int> assigned(count, aColors);
+    vector< vector<double> > sums(workers, vector<double>(aColors * 4));
+    vector<size_t> changed(workers);
+
+    for (iterations = 0; iterations < CONST_REDUCE_MAX_ITERATIONS; )
+    {
+        iterations++;
+        parallel_for(count, [&](unsigned int tt, size_t begin, size_t end) {
+            vector<double> &own = sums[tt];
+            fill(own.begin(), own.end(), 0.0);
+            size_t moved = 0;
+
+            for (size_t jj = begin; jj < end; jj++) {
+                unsigned int best = 0;
+                size_t cc = 0;
+#if defined(__SSE2__)
+                __m128 pl = _mm_set1_ps(L[jj]);
+                __m128 pa = _mm_set1_ps(A[jj]);
+                __m128 pb = _mm_set1_ps(B[jj]);
+                __m128 best_distance = _mm_set1_ps(HUGE_VALF);
+                __m128i best_index = _mm_setzero_si128();
+                __m128i index = _mm_set_epi32(3, 2, 1, 0);
+                const __m128i four = _mm_set1_epi32(4);
+                for (; cc < padded; cc += 4) {
+                    __m128 dl = _mm_sub_ps(_mm_loadu_ps(&cL[cc]), pl);
+                    __m128 da = _mm_sub_ps(_mm_loadu_ps(&cA[cc]), pa);
+                    __m128 db = _mm_sub_ps(_mm_loadu_ps(&cB[cc]), pb);
+                    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dl, dl),
+                        _mm_mul_ps(da, da)), _mm_mul_ps(db, db));
+                    __m128 closer = _mm_cmplt_ps(distance, best_distance);
+                    best_distance = _mm_or_ps(_mm_and_ps(closer, distance),
+                        _mm_andnot_ps(closer, best_distance));
+                    __m128i closer_index = _mm_castps_si128(closer);
+                    best_index = _mm_or_si128(_mm_and_si128(closer_index, index),
+                        _mm_andnot_si128(closer_index, best_index));
+                    index = _mm_add_epi32(index, four);
+                }
+                float lane_distance[4];
+                int lane_index[4];
+                _mm_storeu_ps(lane_distance, best_distance);
+                _mm_storeu_si128((__m128i *)lane_index, best_index);
+                // Nearest of the four lanes, the lower center on a tie.
+                best = lane_index[0];
+                float best_value = lane_distance[0];
+                for (int lane = 1; lane < 4; lane++) {
+                    if ((lane_distance[lane] < best_value) ||
+                        ((lane_distance[lane] == best_value) && ((unsigned)lane_index[lane] < best))) {
+                        best_value = lane_distance[lane];
+                        best = lane_index[lane];
+                    }
+                }
+#else
+                float best_value = HUGE_VALF;
+                for (; cc < aColors; cc++) {
+                    float dl = cL[cc] - L[jj];
+                    float da = cA[cc] - A[jj];
+                    float db = cB[cc] - B[jj];
+                    float distance = dl * dl + da * da + db * db;
+                    if (distance < best_value) {
+                        best_value = distance;
+                        best = cc;
+                    }
+                }
+#endif
+                if (assigned[jj] != best) {
+                    assigned[jj] = best;
+                    moved++;
+                }
+                own[best * 4 + 0] += weight[jj] * L[jj];
+                own[best * 4 + 1] += weight[jj] * A[jj];
+                own[best * 4 + 2] += weight[jj] * B[jj];
+                own[best * 4 + 3] += weight[jj];
+            }
+            changed[tt] = moved;
+        });
+
+        size_t moved = 0;
+        for (unsigned int tt = 0; tt < workers; tt++) moved += changed[tt];
+        if (moved == 0) break;
+
+        // New centers.  An empty cluster keeps its center.
+        for (unsigned int cc = 0; cc < aColors; cc++) {
+            double l = 0.0, a = 0.0, b = 0.0, w = 0.0;
+            for (unsigned int tt = 0; tt < workers; tt++) {
+                l += sums[tt][cc * 4 + 0];
+                a += sums[tt][cc * 4 + 1];
+                b += sums[tt][cc * 4 + 2];
+                w += sums[tt][cc * 4 + 3];
+            }
+            if (w > 0.0) {
+                cL[cc] = l / w;
+                cA[cc] = a / w;
+                cB[cc] = b / w;
+            }
+        }
+    }
+
+    // Palette, largest cluster first.  Empty clusters are dropped.
+    vector<double> cluster_weight(aColors, 0.0);
+    for (unsigned int tt = 0; tt < workers; tt++) {
+        for (unsigned int cc = 0; cc < aColors; cc++) {
+            cluster_weight[cc] += sums[tt][cc * 4 + 3];
+        }
+    }
+    vector<unsigned int> order;
+    for (unsigned int cc = 0; cc < aColors; cc++) {
+        if (cluster_weight[cc] > 0.0) order.push_back(cc);
+    }
+    stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+        return cluster_weight[a] > cluster_weight[b];
+    });
+
+    rgb_node temp;
+    for (ii = 0; ii < order.size(); ii++) {
+        float lab[3] = { cL[order[ii]], cA[order[ii]], cB[order[ii]] };
+        float r, g, b;
+        rgb_remap::from_lab(lab, r, g, b);
+        temp.set_name("color_" + to_string(ii));
+        temp.set_red(r);
+        temp.set_green(g);
+        temp.set_blue(b);
+        palette.push_back(temp);
+    }
+}
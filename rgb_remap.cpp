@@ -0,0 +1,240 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_remap.cpp
+##  This file defines the methods used to snap colors to a palette.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_remap_h__
+#include "include/rgb_remap.h"
+#endif
+
+#ifndef __rgb_configio_h__
+#include "include/rgb_configio.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+static float srgb_to_linear(float value)
+{
+    if (value <= 0.04045f) return value / 12.92f;
+    return pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float lab_f(float t)
+{
+    const float delta = 6.0f / 29.0f;
+    if (t > delta * delta * delta) return cbrt(t);
+    return t / (3.0f * delta * delta) + 4.0f / 29.0f;
+}
+
+static float lab_f_inverse(float t)
+{
+    const float delta = 6.0f / 29.0f;
+    if (t > delta) return t * t * t;
+    return 3.0f * delta * delta * (t - 4.0f / 29.0f);
+}
+
+static float linear_to_srgb(float value)
+{
+    if (value <= 0.0f) return CONST_RGB_COLOR_VALUE_MIN;
+    if (value >= 1.0f) return CONST_RGB_COLOR_VALUE_MAX;
+    if (value <= 0.0031308f) return value * 12.92f;
+    return 1.055f * pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+void rgb_remap::to_lab(float red, float green, float blue, float *lab)
+{
+    float r = srgb_to_linear(red);
+    float g = srgb_to_linear(green);
+    float b = srgb_to_linear(blue);
+
+    // Linear sRGB to XYZ, divided by the D65 white point.
+    float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+    float y = (0.2126f * r + 0.7152f * g + 0.0722f * b);
+    float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+
+    float fx = lab_f(x);
+    float fy = lab_f(y);
+    float fz = lab_f(z);
+
+    lab[0] = 116.0f * fy - 16.0f;
+    lab[1] = 500.0f * (fx - fy);
+    lab[2] = 200.0f * (fy - fz);
+}
+
+void rgb_remap::from_lab(const float *lab, float &red, float &green, float &blue)
+{
+    float fy = (lab[0] + 16.0f) / 116.0f;
+    float fx = fy + lab[1] / 500.0f;
+    float fz = fy - lab[2] / 200.0f;
+
+    float x = lab_f_inverse(fx) * 0.95047f;
+    float y = lab_f_inverse(fy);
+    float z = lab_f_inverse(fz) * 1.08883f;
+
+    red = linear_to_srgb(3.2406f * x - 1.5372f * y - 0.4986f * z);
+    green = linear_to_srgb(-0.9689f * x + 1.8758f * y + 0.0415f * z);
+    blue = linear_to_srgb(0.0557f * x - 0.2040f * y + 1.0570f * z);
+}
+
+void rgb_remap::load(string const &aPaletteConfig)
+{
+    vector<rgb_node> palette_nodes;
+    rgb_configio aConfigObj;
+    aConfigObj.parse_node_config(aPaletteConfig, palette_nodes);
+
+    set_palette(palette_nodes);
+    palette_file = aPaletteConfig;
+}
+
+void rgb_remap::set_palette(vector<rgb_node> const &palette_nodes)
+{
+    clear();
+
+    vector<unsigned int> distinct;
+    vector<unsigned int> node_colors;
+    rgb_configio::build_palette(palette_nodes, distinct, node_colors);
+
+    if (distinct.empty())
+    {
+        aLogger->throw_exception(ENUM_NO_RGB_VALUES_FOUND,
+            "The palette has no colors.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    vector<float> lab(distinct.size() * 3);
+    vector<unsigned int> order(distinct.size());
+    for (unsigned int ii = 0; ii < distinct.size(); ii++)
+    {
+        rgb_node const &aNode = palette_nodes[distinct[ii]];
+        colors.push_back(aNode);
+        to_lab(aNode.get_red(), aNode.get_green(), aNode.get_blue(), &lab[ii * 3]);
+        order[ii] = ii;
+    }
+
+    tree.reserve(colors.size());
+    build(order, lab, 0, order.size(), 0);
+}
+
+int rgb_remap::build(vector<unsigned int> &order, vector<float> const &lab,
+    size_t begin, size_t end, int depth)
+{
+    if (begin >= end) return -1;
+
+    // Split on the median of the axis for this depth.
+    int axis = depth % 3;
+    size_t middle = begin + (end - begin) / 2;
+    nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+        [&lab, axis](unsigned int a, unsigned int b) {
+            return lab[a * 3 + axis] < lab[b * 3 + axis];
+        });
+
+    int position = tree.size();
+    kd_node temp;
+    temp.lab[0] = lab[order[middle] * 3 + 0];
+    temp.lab[1] = lab[order[middle] * 3 + 1];
+    temp.lab[2] = lab[order[middle] * 3 + 2];
+    temp.color = order[middle];
+    temp.axis = axis;
+    temp.left = temp.right = -1;
+    tree.push_back(temp);
+
+    int left = build(order, lab, begin, middle, depth + 1);
+    int right = build(order, lab, middle + 1, end, depth + 1);
+    tree[position].left = left;
+    tree[position].right = right;
+    return position;
+}
+
+void rgb_remap::search(int node, const float *lab, int &best, float &best_distance) const
+{
+    while (node >= 0)
+    {
+        kd_node const &here = tree[node];
+
+        float d0 = lab[0] - here.lab[0];
+        float d1 = lab[1] - here.lab[1];
+        float d2 = lab[2] - here.lab[2];
+        float distance = d0 * d0 + d1 * d1 + d2 * d2;
+        if (distance < best_distance)
+        {
+            best_distance = distance;
+            best = node;
+        }
+
+        // Search the near side first.  The far side can only hold a
+        //  closer color if the splitting plane is closer than the best.
+        float split = lab[here.axis] - here.lab[here.axis];
+        int near_side = (split < 0) ? here.left : here.right;
+        int far_side = (split < 0) ? here.right : here.left;
+
+        if ((far_side >= 0) && (split * split < best_distance))
+        {
+            search(near_side, lab, best, best_distance);
+            node = far_side;
+            if (split * split >= best_distance) break;
+        }
+        else
+        {
+            node = near_side;
+        }
+    }
+}
+
+rgb_node const &rgb_remap::nearest(float red, float green, float blue) const
+{
+    if (tree.empty())
+    {
+        aLogger->throw_exception(ENUM_NO_RGB_VALUES_FOUND,
+            "No palette loaded.",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+
+    float lab[3];
+    to_lab(red, green, blue, lab);
+
+    int best = 0;
+    float best_distance = HUGE_VALF;
+    search(0, lab, best, best_distance);
+    return colors[tree[best].color];
+}
+
+void rgb_remap::apply(vector<rgb_node> const &node_vector,
+    vector<rgb_node> &remapped) const
+{
+    remapped.clear();
+    remapped.reserve(node_vector.size());
+
+    rgb_node temp;
+    for (unsigned int ii = 0; ii < node_vector.size(); ii++)
+    {
+        rgb_node const &aColor = nearest(node_vector[ii].get_red(),
+            node_vector[ii].get_green(), node_vector[ii].get_blue());
+        temp = aColor;
+        temp.set_name(node_vector[ii].get_name());
+        remapped.push_back(temp);
+    }
+}
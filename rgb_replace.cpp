@@ -41,10 +41,18 @@
 
 
 void rgb_replace::replace(string const &rgb_file, string const &rgb_config_file)
+{
+    // Load the config file and replace with it.
+    rgb_config_cache configs;
+    replace(rgb_file, *configs.get(rgb_config_file), rgb_config_file);
+}
+
+void rgb_replace::replace(string const &rgb_file, rgb_node_table const &config_table,
+    string const &rgb_config_file)
 {
     // Replace works in this sequence
     // 1) Extract existing nodes from current file.
-    // 2) Extract nodes from config file.
+    // 2) Take the nodes from the (already parsed) config table.
     // 3) Compare them ... if they are different then...
     // 4) Open a temp file.
     // 5) Parse the source file until we get to the DEF keyword.
@@ -57,21 +65,23 @@ void rgb_replace::replace(string const &rgb_file, string const &rgb_config_file)
 
     // Clear the existing variables.
     clear();
+    match_by_name = keyed;
 
-    // Need to allocate a fileIO object?
-    if (!srcFileIO)
+    // The config table is shared and read only; walk it with an index.
+    //  A transform or palette works on a copy with the same positions.
+    if (pipeline || palette_map)
     {
-        // This opens the source file.
-        srcFileIO = new rgb_fileio();
+        vector<rgb_node> node_vector;
+        node_vector.reserve(config_table.size());
+        for (size_t ii = 0; ii < config_table.size(); ii++) {
+            node_vector.push_back(config_table.node(ii));
+        }
+        adjust(node_vector, pipeline, palette_map);
+        config_nodes = adjusted_nodes.get();
     }
-
-    // Object created?  
-    if (!srcFileIO)
+    else
     {
-        // Unable to allocate the rgb_fileio object.  This is an error.
-        aLogger->throw_exception(ENUM_UNABLE_TO_ALLOCATE_FILEIO,
-            "Unable to allocate rgb_fileio object.", 
-            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        config_nodes = &config_table;
     }
 
     // Extract existing nodes from source file.
@@ -79,19 +89,111 @@ void rgb_replace::replace(string const &rgb_file, string const &rgb_config_file)
     vector<rgb_node> source_node_vector;
     rgbExtract.extract_nodes(rgb_file, source_node_vector);
 
+    rewrite(rgb_file, source_node_vector, config_table.palette,
+        "\"" + rgb_config_file + "\"");
+}
+
+void rgb_replace::recolor(string const &rgb_file, rgb_transform const *aTransform,
+    rgb_remap const *aRemap)
+{
+    // Same as replace() with the file's own nodes, adjusted, as the
+    //  config.
+    clear();
+
+    rgb_extract rgbExtract;
+    vector<rgb_node> source_node_vector;
+    rgbExtract.extract_nodes(rgb_file, source_node_vector);
+
+    adjust(source_node_vector, aTransform, aRemap);
+    config_nodes = adjusted_nodes.get();
+
+    string description;
+    if (aTransform) {
+        description = "the transform \"" + aTransform->get_expression() + "\"";
+    }
+    if (aRemap) {
+        description += (description.empty() ? "" : " and ");
+        description += "the palette \"" + aRemap->get_palette_file() + "\"";
+    }
+    rewrite(rgb_file, source_node_vector, false, description);
+}
+
+void rgb_replace::adjust(vector<rgb_node> const &node_vector,
+    rgb_transform const *aTransform, rgb_remap const *aRemap)
+{
+    vector<rgb_node> adjusted;
+    if (aTransform && aRemap)
+    {
+        vector<rgb_node> transformed;
+        aTransform->apply(node_vector, transformed);
+        aRemap->apply(transformed, adjusted);
+    }
+    else if (aTransform)
+    {
+        aTransform->apply(node_vector, adjusted);
+    }
+    else if (aRemap)
+    {
+        aRemap->apply(node_vector, adjusted);
+    }
+    else
+    {
+        adjusted = node_vector;
+    }
+    adjusted_nodes.reset(new rgb_node_table(adjusted));
+}
+
+void rgb_replace::rewrite(string const &rgb_file, vector<rgb_node> const &source_node_vector,
+    bool palette, string const &target_description)
+{
     // Create and parse a config string based on the RGB nodes from the source file.
     rgb_configio cnfgFileIO;
+    cnfgFileIO.set_timestamp(config_timestamp);
+
+    // The history block is written in the same layout as the new config.
+    cnfgFileIO.set_palette(palette);
     cnfgFileIO.create_node_config(source_node_vector, rgb_file, existing_node_config);
-    cnfgFileIO.parse_node_config(rgb_config_file, config_node_vector);
+
+    // In keyed mode work out what the file will look like after the
+    //  replace and which names have no partner on the other side.
+    vector<rgb_node> target_node_vector;
+    if (match_by_name)
+    {
+        vector<bool> config_used(config_nodes->size(), false);
+        target_node_vector = source_node_vector;
+        for (unsigned int ii = 0; ii < source_node_vector.size(); ii++)
+        {
+            long position = config_nodes->find(source_node_vector[ii].get_name());
+            if (position == CONST_NODE_INDEX_NOT_FOUND) {
+                unmatched_source.push_back(source_node_vector[ii].get_name());
+            } else {
+                config_used[position] = true;
+                target_node_vector[ii] = config_nodes->node(position);
+            }
+        }
+        for (unsigned int ii = 0; ii < config_used.size(); ii++)
+        {
+            if (!config_used[ii]) {
+                unmatched_config.push_back(config_nodes->name(ii));
+            }
+        }
+    }
+    else
+    {
+        target_node_vector.reserve(config_nodes->size());
+        for (size_t ii = 0; ii < config_nodes->size(); ii++) {
+            target_node_vector.push_back(config_nodes->node(ii));
+        }
+    }
 
     // Compare the two node vectors .. are they the same?
-    if (source_node_vector == config_node_vector)
+    if (source_node_vector == target_node_vector)
     {
         // Nothing to do.  Source RGB nodes match the ones in the config file.
         //  This is an error.
         aLogger->throw_exception(ENUM_RGB_NODES_MATCH, 
             "RGB nodes in \"" + rgb_file + "\" match the RGB nodes "
-            + "in \"" + rgb_config_file + "\".  Nothing to do.", 
+            + "in " + target_description + ".  Nothing to do.", 
             __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
     }
 
@@ -115,24 +217,68 @@ void rgb_replace::replace(string const &rgb_file, string const &rgb_config_file)
             __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
     }
 
+    // A dry run only reads the source.  No temp file is made.
     srcFileIO->clear();
-    srcFileIO->open(rgb_file, true);
+    srcFileIO->open(rgb_file, !dry_run);
 
     // Read the source file char by char
     char aChar;
     word_accumulate.clear();
+    read_offset = 0;
     while (srcFileIO->read_char(aChar))
     {
 //cout << "Char:" << aChar << endl; // DEBUG
         // Process the char's through the state machine
         process(aChar);
+        read_offset++;
+
+        // Nothing is copied in a dry run, so the rest can be skipped.
+        if (dry_run && (state == (STATE)&rgb_replace::STATE_NOOP)) break;
     }
 
     // Close open files
     srcFileIO->close();
 
     // Copy the temp file we created over the original file.
-    srcFileIO->overwrite();
+    if (!dry_run) {
+        srcFileIO->overwrite();
+    }
+}
+
+void rgb_replace::emit(string const &A)
+{
+    if (!dry_run) srcFileIO->write(A);
+}
+
+void rgb_replace::emit(char const &A)
+{
+    if (!dry_run) srcFileIO->write(A);
+}
+
+void rgb_replace::add_patch(string const &old_text, rgb_node const &aNode)
+{
+    // Colors that keep their value are not listed.
+    float red = 0.0, green = 0.0, blue = 0.0;
+    istringstream old_colors(old_text);
+    old_colors >> red >> green >> blue;
+    if (old_colors && (red == aNode.get_red()) && (green == aNode.get_green()) &&
+        (blue == aNode.get_blue()))
+    {
+        return;
+    }
+
+    // Same formatting as the values written by the states.
+    stringstream new_text;
+    new_text << aNode.get_red() << " " << aNode.get_green() << " " << aNode.get_blue();
+
+    rgb_patch temp;
+    temp.index = config_index;
+    temp.name = node_name;
+    temp.offset = value_offset;
+    temp.length = read_offset - value_offset;
+    temp.old_value = old_text;
+    temp.new_value = new_text.str();
+    plan.push_back(temp);
 }
 
 void rgb_replace::STATE_verify_VRML(const char &aChar)
@@ -177,7 +323,7 @@ void rgb_replace::STATE_seek_DEF(const char &aChar)
         // Store the accumulate and current char into the temp_string
         //   and write it to the temp file.
         temp_string << word_accumulate << aChar;
-        srcFileIO->write(temp_string.str());
+        emit(temp_string.str());
         word_accumulate.clear();
         temp_string.str(string());
     }
@@ -193,13 +339,42 @@ void rgb_replace::STATE_seek_DIFFUSECOLOR(const char &aChar)
     {
         if (word_accumulate == CONST_STRING_DIFFUSECOLOR_KEYWORD)
         {
+            // Pick the config node that replaces this color.  Only its
+            //  colors are copied out of the table.
+            long position = CONST_NODE_INDEX_NOT_FOUND;
+            if (match_by_name) {
+                position = config_nodes->find(node_name);
+            }
+            else if (config_index < config_nodes->size()) {
+                position = config_index;
+            }
+
+            replacement = NULL;
+            if (position != CONST_NODE_INDEX_NOT_FOUND)
+            {
+                replacement_node.set_red(config_nodes->red(position));
+                replacement_node.set_green(config_nodes->green(position));
+                replacement_node.set_blue(config_nodes->blue(position));
+                replacement = &replacement_node;
+            }
+
             // Transition to replace the RED RGB value
             TRAN((STATE)&rgb_replace::STATE_get_RED);
         }
+        else if (word_accumulate == CONST_STRING_TRANSFORM_KEYWORD)
+        {
+            // Same as the extract: the node name is the word before 
+            //  the Transform keyword.
+            node_name = last_word;
+        }
+        else if (!word_accumulate.empty())
+        {
+            last_word = word_accumulate;
+        }
 
         // Write everything to the the temp file.
         temp_string << word_accumulate << aChar;
-        srcFileIO->write(temp_string.str());
+        emit(temp_string.str());
         word_accumulate.clear();
         temp_string.str(string());
     }
@@ -213,21 +388,28 @@ void rgb_replace::STATE_get_RED(const char &aChar)
 {
     if (isspace(aChar))
     {
+        old_value = word_accumulate;
+
         // Expect float value here
         // Substitute the new RED float value in place of the 
-        //  existing value.
-        temp_string << config_node_vector[0].get_red() << aChar;
+        //  existing value.  Unmatched keyed nodes keep theirs.
+        if (replacement) {
+            temp_string << replacement->get_red() << aChar;
+        } else {
+            temp_string << word_accumulate << aChar;
+        }
 
         // Transition to replace the GREEN RGB value
         TRAN((STATE)&rgb_replace::STATE_get_GREEN);
 
         // Write the temp string to the temp file.
-        srcFileIO->write(temp_string.str());
+        emit(temp_string.str());
         word_accumulate.clear();
         temp_string.str(string());
     }
     else
     {
+        if (word_accumulate.empty()) value_offset = read_offset;
         word_accumulate += aChar;
     }
 }
@@ -236,16 +418,22 @@ void rgb_replace::STATE_get_GREEN(const char &aChar)
 {
     if (isspace(aChar))
     {
+        old_value += " " + word_accumulate;
+
         // Expect float value here
         // Substitute the new GREEN float value in place of the 
-        //  existing value.
-        temp_string << config_node_vector[0].get_green() << aChar;
+        //  existing value.  Unmatched keyed nodes keep theirs.
+        if (replacement) {
+            temp_string << replacement->get_green() << aChar;
+        } else {
+            temp_string << word_accumulate << aChar;
+        }
 
         // Transition to replace the BLUE RGB value
         TRAN((STATE)&rgb_replace::STATE_get_BLUE);
 
         // Write the temp string to the temp file.
-        srcFileIO->write(temp_string.str());
+        emit(temp_string.str());
         word_accumulate.clear();
         temp_string.str(string());
     }
@@ -259,28 +447,35 @@ void rgb_replace::STATE_get_BLUE(const char &aChar)
 {
     if (isspace(aChar))
     {
+        old_value += " " + word_accumulate;
+        if (replacement) {
+            add_patch(old_value, *replacement);
+        }
+
         // Expect float value here
         // Substitute the new BLUE float value in place of the 
-        //  existing value.
-        temp_string << config_node_vector[0].get_blue() << aChar;
-        config_node_vector.erase(config_node_vector.begin());
-
-//cout << "config_node_vector.size() = " << config_node_vector.size() << endl;
+        //  existing value.  Unmatched keyed nodes keep theirs.
+        if (replacement) {
+            temp_string << replacement->get_blue() << aChar;
+        } else {
+            temp_string << word_accumulate << aChar;
+        }
+        config_index++;
 
         // What state do we transition to?
-        if (config_node_vector.empty())
+        if (!match_by_name && (config_index >= config_nodes->size()))
         {
             // There are no more config RGB nodes available to replace...
             // Transition to NOOP and finish the file.
             TRAN((STATE)&rgb_replace::STATE_NOOP);
         } else {
-            // The config_node_vector is not empty.  
+            // There are config RGB nodes left.
             // Seek the next diffuseColor keyword
             TRAN((STATE)&rgb_replace::STATE_seek_DIFFUSECOLOR);
         }
 
         // Write the temp string to the temp file.
-        srcFileIO->write(temp_string.str());
+        emit(temp_string.str());
         word_accumulate.clear();
         temp_string.str(string());
     }
@@ -295,7 +490,7 @@ void rgb_replace::STATE_NOOP(const char &aChar)
 //cout << "NOOP" << endl;
     // No RGB nodes left to replace.  Write the 
     //  remaining chars to the temp file.
-    srcFileIO->write(aChar);
+    emit(aChar);
 }
 
 
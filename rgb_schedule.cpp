@@ -0,0 +1,156 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_schedule.cpp
+##  This file defines the methods used to hand out files to worker threads.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_schedule_h__
+#include "include/rgb_schedule.h"
+#endif
+
+#include <algorithm>
+
+rgb_schedule::rgb_schedule(unsigned int workers)
+: count((workers > 0) ? workers : 1), queues(new worker_queue[(workers > 0) ? workers : 1]),
+  queued(0), idle_count(0), stolen_count(0), closed(false), cancelled(false)
+{
+}
+
+void rgb_schedule::push(size_t task, uint64_t size)
+{
+    // The least loaded worker.  Loads change as soon as they are read;
+    //  a stale choice only costs a steal later.
+    unsigned int target = 0;
+    uint64_t lowest = UINT64_MAX;
+    for (unsigned int ww = 0; ww < count; ww++)
+    {
+        lock_guard<mutex> lock(queues[ww].queue_mutex);
+        uint64_t load = queues[ww].queued_bytes + queues[ww].running_bytes;
+        if (load < lowest)
+        {
+            lowest = load;
+            target = ww;
+        }
+    }
+
+    {
+        worker_queue &aQueue = queues[target];
+        lock_guard<mutex> lock(aQueue.queue_mutex);
+        pair<uint64_t, size_t> temp(size, task);
+
+        // Largest first.  Equal sizes keep the order they were pushed in.
+        deque<pair<uint64_t, size_t> >::iterator where = upper_bound(
+            aQueue.tasks.begin(), aQueue.tasks.end(), temp,
+            [](pair<uint64_t, size_t> const &A, pair<uint64_t, size_t> const &B) {
+                return A.first > B.first; });
+        aQueue.tasks.insert(where, temp);
+        aQueue.queued_bytes += size;
+    }
+
+    lock_guard<mutex> lock(wait_mutex);
+    queued++;
+    ready.notify_one();
+}
+
+void rgb_schedule::close()
+{
+    lock_guard<mutex> lock(wait_mutex);
+    closed = true;
+    ready.notify_all();
+}
+
+void rgb_schedule::cancel()
+{
+    lock_guard<mutex> lock(wait_mutex);
+    cancelled = true;
+    ready.notify_all();
+}
+
+bool rgb_schedule::take(unsigned int from, unsigned int worker, size_t &task)
+{
+    uint64_t size;
+    {
+        worker_queue &aQueue = queues[from];
+        lock_guard<mutex> lock(aQueue.queue_mutex);
+        if (aQueue.tasks.empty()) return false;
+
+        size = aQueue.tasks.front().first;
+        task = aQueue.tasks.front().second;
+        aQueue.tasks.pop_front();
+        aQueue.queued_bytes -= size;
+    }
+    queued--;
+
+    lock_guard<mutex> lock(queues[worker].queue_mutex);
+    queues[worker].running_bytes = size;
+    return true;
+}
+
+bool rgb_schedule::pop(unsigned int worker, size_t &task)
+{
+    {
+        // The task in hand is done.
+        lock_guard<mutex> lock(queues[worker].queue_mutex);
+        queues[worker].running_bytes = 0;
+    }
+
+    for (;;)
+    {
+        {
+            lock_guard<mutex> lock(wait_mutex);
+            if (cancelled) return false;
+        }
+
+        if (take(worker, worker, task)) return true;
+
+        // Steal from the worker with the most bytes still queued.
+        unsigned int victim = worker;
+        uint64_t most = 0;
+        for (unsigned int ww = 0; ww < count; ww++)
+        {
+            if (ww == worker) continue;
+            lock_guard<mutex> lock(queues[ww].queue_mutex);
+            if (!queues[ww].tasks.empty() && (queues[ww].queued_bytes >= most))
+            {
+                most = queues[ww].queued_bytes;
+                victim = ww;
+            }
+        }
+        if ((victim != worker) && take(victim, worker, task))
+        {
+            stolen_count++;
+            return true;
+        }
+
+        unique_lock<mutex> lock(wait_mutex);
+        idle_count++;
+        ready.wait(lock, [this]() { return (queued > 0) || closed || cancelled; });
+
+        // A worker that is done stays counted as idle.
+        if (cancelled || ((queued == 0) && closed)) return false;
+        idle_count--;
+    }
+}
+
@@ -0,0 +1,268 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_transform.cpp
+##  This file defines the methods used to compile and apply color transforms.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_transform_h__
+#include "include/rgb_transform.h"
+#endif
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Luma weights used by the hue and saturation matrices (the same ones as
+//  the SVG feColorMatrix filter), so gray stays gray.
+static const float LUMA_RED = 0.213;
+static const float LUMA_GREEN = 0.715;
+static const float LUMA_BLUE = 0.072;
+
+static float clamp_color(float value)
+{
+    if (value < CONST_RGB_COLOR_VALUE_MIN) return CONST_RGB_COLOR_VALUE_MIN;
+    if (value > CONST_RGB_COLOR_VALUE_MAX) return CONST_RGB_COLOR_VALUE_MAX;
+    return value;
+}
+
+void rgb_transform::compile(string const &anExpression)
+{
+    clear();
+    expression = anExpression;
+
+    size_t start = 0;
+    while (start <= anExpression.size())
+    {
+        size_t end = anExpression.find(',', start);
+        if (end == string::npos) end = anExpression.size();
+        string term(anExpression, start, end - start);
+        start = end + 1;
+
+        size_t equals = term.find('=');
+        string op(term, 0, equals);
+        string value = (equals == string::npos) ? string() : term.substr(equals + 1);
+
+        // Percentages may carry a '%'.
+        bool percent = (!value.empty()) && (value[value.size() - 1] == '%');
+        if (percent) value.erase(value.size() - 1);
+
+        char *number_end = NULL;
+        float number = strtof(value.c_str(), &number_end);
+        bool valid = (!value.empty()) && (*number_end == '\0') && (number == number);
+
+        if (valid && (op == "hue") && !percent)
+        {
+            float angle = number * (float)M_PI / 180.0f;
+            float c = cos(angle);
+            float s = sin(angle);
+            const float hue[9] = {
+                LUMA_RED + c * (1 - LUMA_RED) - s * LUMA_RED,
+                LUMA_GREEN - c * LUMA_GREEN - s * LUMA_GREEN,
+                LUMA_BLUE - c * LUMA_BLUE + s * (1 - LUMA_BLUE),
+                LUMA_RED - c * LUMA_RED + s * 0.143f,
+                LUMA_GREEN + c * (1 - LUMA_GREEN) + s * 0.140f,
+                LUMA_BLUE - c * LUMA_BLUE - s * 0.283f,
+                LUMA_RED - c * LUMA_RED - s * (1 - LUMA_RED),
+                LUMA_GREEN - c * LUMA_GREEN + s * LUMA_GREEN,
+                LUMA_BLUE + c * (1 - LUMA_BLUE) + s * LUMA_BLUE };
+            add_matrix(hue);
+        }
+        else if (valid && ((op == "saturation") || (op == "desaturate")) &&
+            ((op == "saturation") ? (number >= -100.0f) : ((number >= 0.0f) && (number <= 100.0f))))
+        {
+            float s = 1.0f + ((op == "saturation") ? number : -number) / 100.0f;
+            const float saturation[9] = {
+                LUMA_RED + (1 - LUMA_RED) * s, LUMA_GREEN - LUMA_GREEN * s, LUMA_BLUE - LUMA_BLUE * s,
+                LUMA_RED - LUMA_RED * s, LUMA_GREEN + (1 - LUMA_GREEN) * s, LUMA_BLUE - LUMA_BLUE * s,
+                LUMA_RED - LUMA_RED * s, LUMA_GREEN - LUMA_GREEN * s, LUMA_BLUE + (1 - LUMA_BLUE) * s };
+            add_matrix(saturation);
+        }
+        else if (valid && (op == "brightness") && !percent && (number >= 0.0f))
+        {
+            const float brightness[9] = {
+                number, 0, 0,
+                0, number, 0,
+                0, 0, number };
+            add_matrix(brightness);
+        }
+        else if (valid && (op == "gamma") && !percent && (number > 0.0f))
+        {
+            add_gamma(1.0f / number);
+        }
+        else
+        {
+            clear();
+            aLogger->throw_exception(ENUM_UNEXPECTED_COMMAND_PARAMETER,
+                "Invalid transform \"" + term + "\" in \"" + anExpression + "\".  Expected"
+                " hue=<degrees>, saturation=<percent>, desaturate=<percent>,"
+                " brightness=<factor> or gamma=<value>.",
+                __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+        }
+    }
+}
+
+// True if every color inside [MIN,MAX] stays inside it, so a clamp after
+//  aMatrix never changes anything.  Each row is a linear function, so its
+//  extremes are at the corners of the color cube.
+static bool stays_in_range(const float *aMatrix)
+{
+    for (int row = 0; row < 3; row++)
+    {
+        float low = 0;
+        float high = 0;
+        for (int col = 0; col < 3; col++)
+        {
+            float a = aMatrix[row * 3 + col] * CONST_RGB_COLOR_VALUE_MIN;
+            float b = aMatrix[row * 3 + col] * CONST_RGB_COLOR_VALUE_MAX;
+            low += (a < b) ? a : b;
+            high += (a < b) ? b : a;
+        }
+        if ((low < CONST_RGB_COLOR_VALUE_MIN) || (high > CONST_RGB_COLOR_VALUE_MAX)) return false;
+    }
+    return true;
+}
+
+void rgb_transform::add_matrix(const float *aMatrix)
+{
+    // Folding drops the clamp after the previous stage, so only fold when
+    //  that clamp could not have changed a color.
+    if ((!stages.empty()) && (stages.back().kind == ENUM_TRANSFORM_MATRIX) &&
+        stays_in_range(stages.back().matrix))
+    {
+        // Fold into the previous matrix: aMatrix * previous.
+        float *previous = stages.back().matrix;
+        float product[9];
+        for (int row = 0; row < 3; row++) {
+            for (int col = 0; col < 3; col++) {
+                product[row * 3 + col] =
+                    aMatrix[row * 3 + 0] * previous[0 * 3 + col] +
+                    aMatrix[row * 3 + 1] * previous[1 * 3 + col] +
+                    aMatrix[row * 3 + 2] * previous[2 * 3 + col];
+            }
+        }
+        memcpy(previous, product, sizeof(product));
+        return;
+    }
+
+    stage temp;
+    temp.kind = ENUM_TRANSFORM_MATRIX;
+    memcpy(temp.matrix, aMatrix, sizeof(temp.matrix));
+    temp.exponent = 1.0;
+    stages.push_back(temp);
+}
+
+void rgb_transform::add_gamma(float exponent)
+{
+    if ((!stages.empty()) && (stages.back().kind == ENUM_TRANSFORM_GAMMA))
+    {
+        // (c ^ a) ^ b == c ^ (a * b) for colors in [0,1].
+        stages.back().exponent *= exponent;
+        return;
+    }
+
+    stage temp;
+    temp.kind = ENUM_TRANSFORM_GAMMA;
+    memset(temp.matrix, 0, sizeof(temp.matrix));
+    temp.exponent = exponent;
+    stages.push_back(temp);
+}
+
+void rgb_transform::apply(rgb_node_columns &columns) const
+{
+    size_t count = columns.size();
+    if (count == 0) return;
+
+    for (unsigned int ii = 0; ii < stages.size(); ii++)
+    {
+        if (stages[ii].kind == ENUM_TRANSFORM_MATRIX) {
+            apply_matrix(stages[ii].matrix, &columns.red[0], &columns.green[0],
+                &columns.blue[0], count);
+        } else {
+            apply_gamma(stages[ii].exponent, &columns.red[0], count);
+            apply_gamma(stages[ii].exponent, &columns.green[0], count);
+            apply_gamma(stages[ii].exponent, &columns.blue[0], count);
+        }
+    }
+}
+
+void rgb_transform::apply(vector<rgb_node> const &node_vector,
+    vector<rgb_node> &transformed) const
+{
+    rgb_node_columns columns;
+    columns.assign(node_vector);
+    apply(columns);
+    columns.to_nodes(transformed);
+}
+
+void rgb_transform::apply_matrix(const float *aMatrix, float *red, float *green,
+    float *blue, size_t count) const
+{
+    size_t ii = 0;
+
+#if defined(__SSE2__)
+    // Four nodes at a time.
+    const __m128 low = _mm_set1_ps(CONST_RGB_COLOR_VALUE_MIN);
+    const __m128 high = _mm_set1_ps(CONST_RGB_COLOR_VALUE_MAX);
+    __m128 m[9];
+    for (int jj = 0; jj < 9; jj++) m[jj] = _mm_set1_ps(aMatrix[jj]);
+
+    for (; ii + 4 <= count; ii += 4)
+    {
+        __m128 r = _mm_loadu_ps(red + ii);
+        __m128 g = _mm_loadu_ps(green + ii);
+        __m128 b = _mm_loadu_ps(blue + ii);
+
+        __m128 nr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], r), _mm_mul_ps(m[1], g)), _mm_mul_ps(m[2], b));
+        __m128 ng = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[3], r), _mm_mul_ps(m[4], g)), _mm_mul_ps(m[5], b));
+        __m128 nb = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[6], r), _mm_mul_ps(m[7], g)), _mm_mul_ps(m[8], b));
+
+        _mm_storeu_ps(red + ii, _mm_min_ps(_mm_max_ps(nr, low), high));
+        _mm_storeu_ps(green + ii, _mm_min_ps(_mm_max_ps(ng, low), high));
+        _mm_storeu_ps(blue + ii, _mm_min_ps(_mm_max_ps(nb, low), high));
+    }
+#endif
+
+    for (; ii < count; ii++)
+    {
+        float r = red[ii];
+        float g = green[ii];
+        float b = blue[ii];
+        red[ii] = clamp_color(aMatrix[0] * r + aMatrix[1] * g + aMatrix[2] * b);
+        green[ii] = clamp_color(aMatrix[3] * r + aMatrix[4] * g + aMatrix[5] * b);
+        blue[ii] = clamp_color(aMatrix[6] * r + aMatrix[7] * g + aMatrix[8] * b);
+    }
+}
+
+void rgb_transform::apply_gamma(float exponent, float *column, size_t count) const
+{
+    // No SSE pow().  Plain loop over the column.
+    for (size_t ii = 0; ii < count; ii++)
+    {
+        column[ii] = clamp_color(pow(column[ii], exponent));
+    }
+}
@@ -0,0 +1,262 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: rgb_walk.cpp
+##  This file defines the methods used to walk a directory tree.
+##
+## Usage:
+##   -help  : Prints usage information
+##   -info  : Prints usage information
+##
+*/
+#ifndef __rgb_walk_h__
+#include "include/rgb_walk.h"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <dirent.h>
+#include <exception>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+unsigned int rgb_walk::worker_count() const
+{
+    if (threads > 0) return threads;
+    unsigned int cores = std::thread::hardware_concurrency();
+    return (cores > 0) ? cores : 1;
+}
+
+void rgb_walk::walk(string const &root, file_found const &found)
+{
+    clear();
+    pending.clear();
+    visited.clear();
+    busy = 0;
+    stop = false;
+
+    int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        aLogger->throw_exception(ENUM_FILE_OR_DIRECTORY_NOT_FOUND,
+            "Unable to open the directory \"" + root + "\".",
+            __PRETTY_FUNCTION__, __FILE__, __LINE__, STRING_error_layer);
+    }
+    struct stat info;
+    if ((links == ENUM_LINKS_FOLLOW) && (fstat(fd, &info) == 0)) first_visit(info);
+
+    // Paths are built as root + "/" + name.
+    string base(root);
+    while ((base.size() > 1) && (base[base.size() - 1] == '/')) {
+        base.erase(base.size() - 1);
+    }
+    pending_directory temp = { fd, base, 0 };
+    pending.push_back(temp);
+
+    exception_ptr failure;
+    auto run = [&]() {
+        for (;;)
+        {
+            pending_directory next;
+            {
+                // Wait for a directory or for the last busy thread to finish.
+                unique_lock<mutex> lock(pending_mutex);
+                pending_ready.wait(lock, [this]() {
+                    return !pending.empty() || (busy == 0) || stop; });
+                if (pending.empty() || stop) return;
+                next = pending.back();
+                pending.pop_back();
+                busy++;
+            }
+
+            try {
+                read_directory(next, found);
+            } catch (...) {
+                lock_guard<mutex> lock(pending_mutex);
+                if (!failure) failure = current_exception();
+                stop = true;
+            }
+
+            lock_guard<mutex> lock(pending_mutex);
+            busy--;
+            if ((busy == 0) || stop) pending_ready.notify_all();
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned int ww = 1; ww < worker_count(); ww++) {
+        pool.push_back(thread(run));
+    }
+    run();
+    for (unsigned int ww = 0; ww < pool.size(); ww++) {
+        pool[ww].join();
+    }
+
+    // Only left when the walk was stopped.
+    for (unsigned int ii = 0; ii < pending.size(); ii++) {
+        close(pending[ii].fd);
+    }
+    pending.clear();
+
+    if (failure) rethrow_exception(failure);
+}
+
+void rgb_walk::read_directory(pending_directory const &aDirectory, file_found const &found)
+{
+    DIR *stream = fdopendir(aDirectory.fd);
+    if (stream == NULL)
+    {
+        close(aDirectory.fd);
+        unreadable++;
+        return;
+    }
+    directories++;
+
+    // The names first, so the directory can be walked in name order.
+    vector<pair<string, unsigned char> > entries;
+    struct dirent *anEntry;
+    errno = 0;
+    while ((anEntry = readdir(stream)) != NULL)
+    {
+        string name(anEntry->d_name);
+        if ((name == ".") || (name == "..")) continue;
+        entries.push_back(make_pair(name, anEntry->d_type));
+    }
+    if (errno != 0) unreadable++;
+    sort(entries.begin(), entries.end());
+
+    int fd = dirfd(stream);
+    string prefix = (aDirectory.path == "/") ? aDirectory.path : aDirectory.path + "/";
+
+    try {
+        for (unsigned int ii = 0; (ii < entries.size()) && !stop; ii++)
+        {
+            string const &name = entries[ii].first;
+            unsigned char type = entries[ii].second;
+            struct stat info;
+            bool have_info = false;
+
+            if (type == DT_UNKNOWN)
+            {
+                if (fstatat(fd, name.c_str(), &info, AT_SYMLINK_NOFOLLOW) != 0) continue;
+                type = IFTODT(info.st_mode);
+                have_info = true;
+            }
+
+            bool through_link = false;
+            if (type == DT_LNK)
+            {
+                if ((links == ENUM_LINKS_SKIP) ||
+                    (fstatat(fd, name.c_str(), &info, 0) != 0))
+                {
+                    links_skipped++;
+                    continue;
+                }
+                type = IFTODT(info.st_mode);
+                have_info = true;
+                through_link = true;
+                if ((type == DT_DIR) && (links != ENUM_LINKS_FOLLOW))
+                {
+                    links_skipped++;
+                    continue;
+                }
+            }
+
+            if (type == DT_DIR)
+            {
+                if ((max_depth >= 0) && (aDirectory.depth >= max_depth))
+                {
+                    too_deep++;
+                    continue;
+                }
+                int child = open_directory(fd, name, through_link);
+                if (child < 0) continue;
+
+                pending_directory temp = { child, prefix + name, aDirectory.depth + 1 };
+                bool queued = false;
+                {
+                    lock_guard<mutex> lock(pending_mutex);
+                    if (pending.size() < CONST_WALK_MAX_PENDING)
+                    {
+                        pending.push_back(temp);
+                        queued = true;
+                    }
+                }
+                if (queued) pending_ready.notify_one();
+                else read_directory(temp, found);
+            }
+            else if (type == DT_REG)
+            {
+                if (filter && !filter(name)) continue;
+                if (!have_info &&
+                    (fstatat(fd, name.c_str(), &info, AT_SYMLINK_NOFOLLOW) != 0)) continue;
+
+                // Through links the same file can be reached twice.
+                if ((links != ENUM_LINKS_SKIP) && !first_visit(info))
+                {
+                    if (through_link) links_skipped++;
+                    continue;
+                }
+
+                rgb_walk_entry temp;
+                temp.path = prefix + name;
+                temp.size = info.st_size;
+                temp.depth = aDirectory.depth;
+                found(temp);
+            }
+        }
+    } catch (...) {
+        closedir(stream);
+        throw;
+    }
+    closedir(stream);
+}
+
+int rgb_walk::open_directory(int parent_fd, string const &name, bool follow)
+{
+    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    if (!follow) flags |= O_NOFOLLOW;
+
+    int fd = openat(parent_fd, name.c_str(), flags);
+    if (fd < 0)
+    {
+        unreadable++;
+        return -1;
+    }
+
+    // A link back up the tree would be walked forever.
+    struct stat info;
+    if ((links == ENUM_LINKS_FOLLOW) && (fstat(fd, &info) == 0) && !first_visit(info))
+    {
+        if (follow) links_skipped++;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool rgb_walk::first_visit(struct stat const &info)
+{
+    lock_guard<mutex> lock(visited_mutex);
+    return visited.insert(make_pair(info.st_dev, info.st_ino)).second;
+}
+
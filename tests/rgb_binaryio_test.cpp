@@ -0,0 +1,193 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: tests/rgb_binaryio_test.cpp
+##  Writes a node vector as a binary node file, reads it back through
+##   decode(), rgb_binary_view and rgb_node_table and compares the names
+##   and colors.  A file with a damaged header must be rejected.
+##
+## Usage:
+##   make test
+##
+*/
+#ifndef __rgb_binaryio_h__
+#include "../include/rgb_binaryio.h"
+#endif
+
+#ifndef __rgb_configio_h__
+#include "../include/rgb_configio.h"
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool condition, string const &what)
+{
+    if (!condition) {
+        cerr << "FAILED : " << what << endl;
+        failures++;
+    }
+}
+
+static vector<char> read_all(string const &file_name)
+{
+    ifstream in_file(file_name.c_str(), ios::in | ios::binary);
+    return vector<char>((istreambuf_iterator<char>(in_file)), istreambuf_iterator<char>());
+}
+
+static void write_all(string const &file_name, vector<char> const &buffer)
+{
+    ofstream out_file(file_name.c_str(), ios::out | ios::trunc | ios::binary);
+    out_file.write(&buffer[0], buffer.size());
+}
+
+static vector<rgb_node> sample_nodes()
+{
+    const char *names[] = { "Shape_chair", "", "Shape_table_top", "Shape_leg_1" };
+    const float colors[][3] = {
+        { 0.0f, 0.5f, 1.0f },
+        { 0.25f, 0.125f, 0.0625f },
+        { 1.0f, 1.0f, 1.0f },
+        { 0.1f, 0.2f, 0.3f }
+    };
+
+    vector<rgb_node> node_vector;
+    for (size_t ii = 0; ii < sizeof(names) / sizeof(names[0]); ii++)
+    {
+        rgb_node aNode;
+        aNode.set_name(names[ii]);
+        aNode.set_red(colors[ii][0]);
+        aNode.set_green(colors[ii][1]);
+        aNode.set_blue(colors[ii][2]);
+        node_vector.push_back(aNode);
+    }
+    return node_vector;
+}
+
+static void test_round_trip(string const &file_name)
+{
+    vector<rgb_node> node_vector = sample_nodes();
+    rgb_binaryio binaryIO;
+    binaryIO.write_node_binary_file(node_vector, "models/chair.wrl", file_name);
+
+    vector<char> buffer = read_all(file_name);
+    rgb_node_columns node_columns;
+    string source_file;
+    binaryIO.decode(&buffer[0], buffer.size(), node_columns, source_file, file_name);
+
+    check(source_file == "models/chair.wrl", "decode source file");
+    check(node_columns.size() == node_vector.size(), "decode node count");
+    for (size_t ii = 0; (ii < node_vector.size()) && (ii < node_columns.size()); ii++)
+    {
+        check(node_columns.name[ii] == node_vector[ii].get_name(), "decode name");
+        check(node_columns.red[ii] == node_vector[ii].get_red(), "decode red");
+        check(node_columns.green[ii] == node_vector[ii].get_green(), "decode green");
+        check(node_columns.blue[ii] == node_vector[ii].get_blue(), "decode blue");
+    }
+
+    rgb_binary_view aView;
+    aView.open(file_name);
+    check(aView.source() == "models/chair.wrl", "view source file");
+    check(aView.size() == node_vector.size(), "view node count");
+    for (size_t ii = 0; (ii < node_vector.size()) && (ii < aView.size()); ii++)
+    {
+        check(aView.name(ii) == node_vector[ii].get_name(), "view name");
+        check(aView.red(ii) == node_vector[ii].get_red(), "view red");
+        check(aView.green(ii) == node_vector[ii].get_green(), "view green");
+        check(aView.blue(ii) == node_vector[ii].get_blue(), "view blue");
+    }
+
+    // The config table reads the same file in place.
+    rgb_node_table aTable(file_name);
+    check(aTable.size() == node_vector.size(), "table node count");
+    for (size_t ii = 0; (ii < node_vector.size()) && (ii < aTable.size()); ii++)
+    {
+        check(aTable.name(ii) == node_vector[ii].get_name(), "table name");
+        check(aTable.node(ii) == node_vector[ii], "table colors");
+        check(aTable.red_column()[ii] == node_vector[ii].get_red(), "table red column");
+        check(aTable.find(node_vector[ii].get_name()) == (long)ii, "table find");
+    }
+    check(aTable.find("Shape_missing") == CONST_NODE_INDEX_NOT_FOUND, "table find missing");
+
+    vector<rgb_node> read_vector;
+    aView.to_nodes(read_vector);
+    check(read_vector.size() == node_vector.size(), "view to_nodes count");
+    for (size_t ii = 0; (ii < node_vector.size()) && (ii < read_vector.size()); ii++)
+    {
+        check(read_vector[ii].get_name() == node_vector[ii].get_name(), "view to_nodes name");
+        check(read_vector[ii] == node_vector[ii], "view to_nodes colors");
+    }
+}
+
+// The source file name is the last section.  An offset past the end of
+//  the file must be rejected, not wrapped around in the size test.
+static void test_source_offset_past_end(string const &file_name)
+{
+    rgb_binaryio binaryIO;
+    binaryIO.write_node_binary_file(sample_nodes(), "models/chair.wrl", file_name);
+
+    vector<char> buffer = read_all(file_name);
+    rgb_binaryio::put_u64(&buffer[80], buffer.size() + 16);
+    rgb_binaryio::put_u64(&buffer[88], 4);
+    write_all(file_name, buffer);
+
+    bool rejected = false;
+    try {
+        rgb_node_columns node_columns;
+        string source_file;
+        binaryIO.decode(&buffer[0], buffer.size(), node_columns, source_file, file_name);
+    } catch (ErrException &) {
+        rejected = true;
+    }
+    check(rejected, "decode rejects a source offset past the end");
+
+    rejected = false;
+    try {
+        rgb_binary_view aView;
+        aView.open(file_name);
+    } catch (ErrException &) {
+        rejected = true;
+    }
+    check(rejected, "view rejects a source offset past the end");
+}
+
+int main()
+{
+    const string file_name = "rgb_binaryio_test.bin";
+
+    try {
+        test_round_trip(file_name);
+        test_source_offset_past_end(file_name);
+    } catch (ErrException &e) {
+        cerr << "FAILED : unexpected exception: " << e.what() << endl;
+        failures++;
+    }
+    remove(file_name.c_str());
+
+    if (failures != 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "rgb_binaryio_test : passed" << endl;
+    return 0;
+}
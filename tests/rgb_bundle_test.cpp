@@ -0,0 +1,209 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: tests/rgb_bundle_test.cpp
+##  Writes a bundle, opens it again and looks up its configs, by path and
+##   by file name.  A config that does not match its hash and a bundle
+##   with a damaged header or index must be rejected.
+##
+## Usage:
+##   make test
+##
+*/
+#ifndef __rgb_bundle_h__
+#include "../include/rgb_bundle.h"
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool condition, string const &what)
+{
+    if (!condition) {
+        cerr << "FAILED : " << what << endl;
+        failures++;
+    }
+}
+
+static vector<char> read_all(string const &file_name)
+{
+    ifstream in_file(file_name.c_str(), ios::in | ios::binary);
+    return vector<char>((istreambuf_iterator<char>(in_file)), istreambuf_iterator<char>());
+}
+
+static void write_all(string const &file_name, vector<char> const &buffer)
+{
+    ofstream out_file(file_name.c_str(), ios::out | ios::trunc | ios::binary);
+    out_file.write(&buffer[0], buffer.size());
+}
+
+static const string chair_config = "#RGB_NODE_CONFIG V001\n\"Shape_chair\" 0 0.5 1\n";
+static const string table_config = "#RGB_NODE_CONFIG V001\n\"Shape_table\" 1 1 1\n";
+
+// The config of source_file, empty if find() threw.
+static string find_config(rgb_bundle const &aBundle, string const &source_file,
+    enum EXCEPTION_STRING_ARRAY &code)
+{
+    code = ENUM_LAST_ELEMENT;
+    try {
+        const char *data;
+        uint64_t length;
+        aBundle.find(source_file, data, length);
+        return string(data, length);
+    } catch (ErrException &e) {
+        code = e.error();
+    }
+    return string();
+}
+
+static void write_sample(string const &file_name)
+{
+    rgb_bundle aBundle;
+    aBundle.add("models/chair.wrl", chair_config);
+    aBundle.add("models/table.wrl", table_config);
+    aBundle.write(file_name);
+}
+
+static void test_round_trip(string const &file_name)
+{
+    write_sample(file_name);
+    check(rgb_bundle::is_bundle_file(file_name), "written file is a bundle");
+
+    rgb_bundle aBundle;
+    aBundle.open(file_name);
+    check(aBundle.size() == 2, "bundle size");
+
+    enum EXCEPTION_STRING_ARRAY code;
+    check(find_config(aBundle, "models/chair.wrl", code) == chair_config, "find by path");
+    check(find_config(aBundle, "models/table.wrl", code) == table_config, "find second path");
+    check(find_config(aBundle, "moved/chair.wrl", code) == chair_config, "find by file name");
+
+    find_config(aBundle, "models/lamp.wrl", code);
+    check(code == ENUM_NOT_IN_BUNDLE, "missing config is not in the bundle");
+
+    // Replacing one config keeps the other.
+    aBundle.add("models/chair.wrl", table_config);
+    aBundle.write(file_name);
+    aBundle.open(file_name);
+    check(aBundle.size() == 2, "bundle size after replace");
+    check(find_config(aBundle, "models/chair.wrl", code) == table_config, "replaced config");
+    check(find_config(aBundle, "models/table.wrl", code) == table_config, "kept config");
+}
+
+static void test_hash_mismatch(string const &file_name)
+{
+    write_sample(file_name);
+
+    // The configs are written last, in path order: change the table's.
+    vector<char> buffer = read_all(file_name);
+    buffer[buffer.size() - 2] = '0';
+    write_all(file_name, buffer);
+
+    rgb_bundle aBundle;
+    aBundle.open(file_name);
+    enum EXCEPTION_STRING_ARRAY code;
+    check(find_config(aBundle, "models/chair.wrl", code) == chair_config, "intact config still found");
+    find_config(aBundle, "models/table.wrl", code);
+    check(code == ENUM_INVALID_BUNDLE_FILE, "changed config fails its hash");
+}
+
+// Writes the sample, changes the 8 or 4 bytes at offset and expects open()
+//  to reject the bundle.
+static void expect_invalid(string const &file_name, size_t offset, uint64_t value,
+    bool wide, string const &what)
+{
+    write_sample(file_name);
+    vector<char> buffer = read_all(file_name);
+    if (wide) {
+        rgb_binaryio::put_u64(&buffer[offset], value);
+    } else {
+        rgb_binaryio::put_u32(&buffer[offset], (uint32_t)value);
+    }
+    write_all(file_name, buffer);
+
+    enum EXCEPTION_STRING_ARRAY code = ENUM_LAST_ELEMENT;
+    try {
+        rgb_bundle aBundle;
+        aBundle.open(file_name);
+    } catch (ErrException &e) {
+        code = e.error();
+    }
+    check(code == ENUM_INVALID_BUNDLE_FILE, "open rejects " + what);
+}
+
+static void test_read_index(string const &file_name)
+{
+    const size_t entry = CONST_BUNDLE_HEADER_SIZE;
+    const uint64_t huge = ~(uint64_t)0;
+
+    expect_invalid(file_name, 0, 0, true, "a wrong magic");
+    expect_invalid(file_name, 8, CONST_BUNDLE_CURRENT_VERSION + 1, false, "a newer version");
+    expect_invalid(file_name, 12, CONST_BUNDLE_HEADER_SIZE - 1, false, "a short header size");
+    expect_invalid(file_name, 12, 0xFFFFFFFF, false, "a header size past the end");
+
+    // Counts that would overflow count * entry size.
+    expect_invalid(file_name, 16, huge, true, "an entry count of 2^64 - 1");
+    expect_invalid(file_name, 16, huge / CONST_BUNDLE_ENTRY_SIZE + 1, true,
+        "an entry count that wraps the index size");
+    expect_invalid(file_name, 16, 3, true, "one entry too many");
+
+    expect_invalid(file_name, entry, huge, true, "a config offset past the end");
+    expect_invalid(file_name, entry + 8, huge, true, "a config length that wraps");
+    expect_invalid(file_name, entry + 24, 0xFFFFFFFF, false, "a source path past the end");
+
+    // A bundle cut short in its index.
+    write_sample(file_name);
+    vector<char> buffer = read_all(file_name);
+    buffer.resize(entry + CONST_BUNDLE_ENTRY_SIZE / 2);
+    write_all(file_name, buffer);
+    bool rejected = false;
+    try {
+        rgb_bundle aBundle;
+        aBundle.open(file_name);
+    } catch (ErrException &) {
+        rejected = true;
+    }
+    check(rejected, "open rejects a truncated index");
+}
+
+int main()
+{
+    const string file_name = "rgb_bundle_test.bundle";
+
+    try {
+        test_round_trip(file_name);
+        test_hash_mismatch(file_name);
+        test_read_index(file_name);
+    } catch (ErrException &e) {
+        cerr << "FAILED : unexpected exception: " << e.what() << endl;
+        failures++;
+    }
+    remove(file_name.c_str());
+
+    if (failures != 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "rgb_bundle_test : passed" << endl;
+    return 0;
+}
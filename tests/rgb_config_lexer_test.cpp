@@ -0,0 +1,141 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: tests/rgb_config_lexer_test.cpp
+##  Checks that parse_number() gives the same double as strtod for the
+##   numbers it converts itself and for the ones it hands on, rejects text
+##   that is not a whole number, and that the lexer reports bad colors and
+##   counts at their line and column.
+##
+## Usage:
+##   make test
+##
+*/
+#ifndef __rgb_config_lexer_h__
+#include "../include/rgb_config_lexer.h"
+#endif
+
+#include <cstdlib>
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool condition, string const &what)
+{
+    if (!condition) {
+        cerr << "FAILED : " << what << endl;
+        failures++;
+    }
+}
+
+static void test_numbers()
+{
+    const char *numbers[] = {
+        "0", "1", "0.5", ".5", "5.", "-0.25", "+1", "00.0100",
+        "0.123456789", "0.30000000000000004", "1e-3", "1E+2", "2.5e0",
+        "0.000001", "1e22", "1e-22",
+        // Past the direct conversion: strtod.
+        "12345678901234567890", "0.12345678901234567890123",
+        "9007199254740993", "1e23", "1e-30", "1e400", "1e-400"
+    };
+    for (size_t ii = 0; ii < sizeof(numbers) / sizeof(numbers[0]); ii++)
+    {
+        string text(numbers[ii]);
+        double value = -1;
+        bool parsed = rgb_config_lexer::parse_number(text.data(), text.size(), value);
+        check(parsed && (value == strtod(text.c_str(), NULL)),
+            "parse_number(\"" + text + "\") matches strtod");
+    }
+
+    const char *not_numbers[] = {
+        "", "-", "+", ".", "-.", "e5", "1e", "1e+", "1.2.3", "0x10",
+        "1,5", "nan", "inf", "--1", "1 ", " 1", "1f"
+    };
+    for (size_t ii = 0; ii < sizeof(not_numbers) / sizeof(not_numbers[0]); ii++)
+    {
+        string text(not_numbers[ii]);
+        double value;
+        check(!rgb_config_lexer::parse_number(text.data(), text.size(), value),
+            "parse_number(\"" + text + "\") is not a number");
+    }
+
+    // Only size chars are read; the buffer need not end after them.
+    double value = -1;
+    check(rgb_config_lexer::parse_number("0.75junk", 4, value) && (value == 0.75),
+        "parse_number stops at size");
+}
+
+// The message of the error converting the second token of text, empty if
+//  there was none.
+static string convert_error(string const &text, bool as_color)
+{
+    rgb_config_lexer aLexer;
+    aLexer.open(text.data(), text.size(), "\"test\"");
+
+    rgb_config_token aToken;
+    aLexer.next(aToken);
+    aLexer.next(aToken);
+    try {
+        if (as_color) aLexer.to_color(aToken);
+        else aLexer.to_count(aToken);
+    } catch (ErrException &e) {
+        check(e.error() == ENUM_CONFIG_PARSE_ERROR, "conversion error code");
+        return e.what();
+    }
+    return string();
+}
+
+static void test_conversions()
+{
+    check(convert_error("x\n  0.5", true).empty(), "to_color accepts 0.5");
+    check(convert_error("x 1", true).empty(), "to_color accepts 1");
+    check(convert_error("x\n  1.5", true).find("line 2, column 3") != string::npos,
+        "to_color rejects 1.5 at its position");
+    check(!convert_error("x -0.1", true).empty(), "to_color rejects -0.1");
+    check(!convert_error("x 1e400", true).empty(), "to_color rejects an infinite value");
+    check(!convert_error("x red", true).empty(), "to_color rejects a word");
+
+    check(convert_error("x 42", false).empty(), "to_count accepts 42");
+    check(!convert_error("x 4.2", false).empty(), "to_count rejects 4.2");
+    check(!convert_error("x 1234567890123456789", false).empty(), "to_count rejects 19 digits");
+}
+
+int main()
+{
+    // The position is only in the verbose message.
+    LoggerLevel *aLogger = LoggerLevel::getInstance();
+    aLogger->setLevel(ENUM_VERBOSE);
+
+    try {
+        test_numbers();
+        test_conversions();
+    } catch (ErrException &e) {
+        cerr << "FAILED : unexpected exception: " << e.what() << endl;
+        failures++;
+    }
+    aLogger->releaseInstance();
+
+    if (failures != 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "rgb_config_lexer_test : passed" << endl;
+    return 0;
+}
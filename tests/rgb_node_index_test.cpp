@@ -0,0 +1,128 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: tests/rgb_node_index_test.cpp
+##  Builds the node name index from names and from nodes and looks every
+##   name up: the first of a repeated name wins and a name not in the
+##   config is not found.
+##
+## Usage:
+##   make test
+##
+*/
+#ifndef __rgb_node_index_h__
+#include "../include/rgb_node_index.h"
+#endif
+
+#include <iostream>
+#include <sstream>
+
+static int failures = 0;
+
+static void check(bool condition, string const &what)
+{
+    if (!condition) {
+        cerr << "FAILED : " << what << endl;
+        failures++;
+    }
+}
+
+static void test_empty()
+{
+    rgb_node_index anIndex;
+    check(anIndex.find("Shape_chair") == CONST_NODE_INDEX_NOT_FOUND, "empty index finds nothing");
+
+    anIndex.build(vector<string>());
+    check(anIndex.size() == 0, "index of no names");
+    check(anIndex.find("") == CONST_NODE_INDEX_NOT_FOUND, "index of no names finds nothing");
+}
+
+static void test_repeated_names()
+{
+    const char *names[] = { "Shape_leg", "", "Shape_top", "Shape_leg", "", "Shape_top_" };
+    vector<string> node_names(names, names + sizeof(names) / sizeof(names[0]));
+
+    rgb_node_index anIndex;
+    anIndex.build(node_names);
+    check(anIndex.size() == node_names.size(), "every name is kept");
+    check(anIndex.find("Shape_leg") == 0, "first repeated name wins");
+    check(anIndex.find("") == 1, "empty name is a name");
+    check(anIndex.find("Shape_top") == 2, "name found");
+    check(anIndex.find("Shape_top_") == 5, "longer name found");
+    check(anIndex.find("Shape_to") == CONST_NODE_INDEX_NOT_FOUND, "prefix is not found");
+
+    // The node vector gives the same index.
+    vector<rgb_node> node_vector;
+    for (size_t ii = 0; ii < node_names.size(); ii++)
+    {
+        rgb_node aNode;
+        aNode.set_name(node_names[ii]);
+        node_vector.push_back(aNode);
+    }
+    rgb_node_index aNodeIndex;
+    aNodeIndex.build(node_vector);
+    for (size_t ii = 0; ii < node_names.size(); ii++) {
+        check(aNodeIndex.find(node_names[ii]) == anIndex.find(node_names[ii]),
+            "node vector index matches name index");
+    }
+}
+
+// Enough names to grow the table well past its first size, so probe runs
+//  wrap and collide.
+static void test_many_names()
+{
+    vector<string> node_names;
+    for (unsigned int ii = 0; ii < 20000; ii++)
+    {
+        stringstream aName;
+        aName << "Shape_" << ii;
+        node_names.push_back(aName.str());
+    }
+
+    rgb_node_index anIndex;
+    anIndex.build(node_names);
+
+    bool all_found = true;
+    for (size_t ii = 0; ii < node_names.size(); ii++) {
+        all_found = all_found && (anIndex.find(node_names[ii]) == (long)ii);
+    }
+    check(all_found, "every one of many names found");
+    check(anIndex.find("Shape_20000") == CONST_NODE_INDEX_NOT_FOUND, "missing name among many");
+
+    // Building again drops the old names.
+    anIndex.build(vector<string>(1, "Shape_chair"));
+    check(anIndex.size() == 1, "rebuilt index size");
+    check(anIndex.find("Shape_chair") == 0, "rebuilt index finds new name");
+    check(anIndex.find("Shape_0") == CONST_NODE_INDEX_NOT_FOUND, "rebuilt index drops old names");
+}
+
+int main()
+{
+    test_empty();
+    test_repeated_names();
+    test_many_names();
+
+    if (failures != 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "rgb_node_index_test : passed" << endl;
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+##
+## Copyright Oct 2013 James Stokebkrand
+##
+## Licensed under the Apache License, Version 2.0 (the "License");
+## you may not use this file except in compliance with the License.
+## You may obtain a copy of the License at
+##
+## http://www.apache.org/licenses/LICENSE-2.0
+##
+## Unless required by applicable law or agreed to in writing, software
+## distributed under the License is distributed on an "AS IS" BASIS,
+## WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+## See the License for the specific language governing permissions and
+## limitations under the License.
+##
+## Purpose:
+##  This is a command line tool to extract, replace and rollback RGB nodes
+##   inside VRML V2.0 files.  (File extention WRL)
+##
+## Filename: tests/rgb_transform_test.cpp
+##  Compiles transform chains, where matrices and gammas may be folded
+##   together, and compares the result with running each operator on its
+##   own with the clamp after it.
+##
+## Usage:
+##   make test
+##
+*/
+#ifndef __rgb_transform_h__
+#include "../include/rgb_transform.h"
+#endif
+
+#include <cmath>
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool condition, string const &what)
+{
+    if (!condition) {
+        cerr << "FAILED : " << what << endl;
+        failures++;
+    }
+}
+
+// Every mix of a few levels, dark, light and both ends.  The count is not
+//  a multiple of four, so the SSE2 loop and the one after it both run.
+static rgb_node_columns sample_columns()
+{
+    const float levels[] = { 0.0f, 0.1f, 0.25f, 0.5f, 0.75f, 0.9f, 1.0f };
+    const size_t count = sizeof(levels) / sizeof(levels[0]);
+
+    rgb_node_columns columns;
+    for (size_t rr = 0; rr < count; rr++) {
+        for (size_t gg = 0; gg < count; gg++) {
+            for (size_t bb = 0; bb < count; bb++) {
+                columns.name.push_back("Shape");
+                columns.red.push_back(levels[rr]);
+                columns.green.push_back(levels[gg]);
+                columns.blue.push_back(levels[bb]);
+            }
+        }
+    }
+    return columns;
+}
+
+// anExpression compiled as one chain against one operator at a time.
+static void test_chain(string const &anExpression)
+{
+    rgb_node_columns folded = sample_columns();
+    rgb_transform aTransform;
+    aTransform.compile(anExpression);
+    aTransform.apply(folded);
+
+    rgb_node_columns staged = sample_columns();
+    size_t begin = 0;
+    while (begin <= anExpression.size())
+    {
+        size_t end = anExpression.find(',', begin);
+        if (end == string::npos) end = anExpression.size();
+
+        rgb_transform aStage;
+        aStage.compile(anExpression.substr(begin, end - begin));
+        aStage.apply(staged);
+        begin = end + 1;
+    }
+
+    // Folding changes the float rounding, not the result.
+    bool same = (folded.size() == staged.size());
+    for (size_t ii = 0; same && (ii < folded.size()); ii++)
+    {
+        same = (fabs(folded.red[ii] - staged.red[ii]) < 1e-5) &&
+            (fabs(folded.green[ii] - staged.green[ii]) < 1e-5) &&
+            (fabs(folded.blue[ii] - staged.blue[ii]) < 1e-5);
+    }
+    check(same, "\"" + anExpression + "\" matches its stages one at a time");
+
+    bool in_range = true;
+    for (size_t ii = 0; ii < folded.size(); ii++)
+    {
+        in_range = in_range &&
+            (folded.red[ii] >= CONST_RGB_COLOR_VALUE_MIN) && (folded.red[ii] <= CONST_RGB_COLOR_VALUE_MAX) &&
+            (folded.green[ii] >= CONST_RGB_COLOR_VALUE_MIN) && (folded.green[ii] <= CONST_RGB_COLOR_VALUE_MAX) &&
+            (folded.blue[ii] >= CONST_RGB_COLOR_VALUE_MIN) && (folded.blue[ii] <= CONST_RGB_COLOR_VALUE_MAX);
+    }
+    check(in_range, "\"" + anExpression + "\" keeps colors in range");
+}
+
+int main()
+{
+    try {
+        // brightness=2 leaves the range, so its clamp must be kept.
+        test_chain("brightness=2,desaturate=50");
+        test_chain("brightness=2,brightness=0.5");
+        test_chain("saturation=80,hue=120");
+        test_chain("hue=40,brightness=0.8,desaturate=20");
+
+        // These stay in range and are folded.
+        test_chain("desaturate=50,brightness=2");
+        test_chain("desaturate=30,saturation=-20,brightness=0.5");
+        test_chain("brightness=0.5,brightness=0.5,hue=-30");
+        test_chain("gamma=2.2,gamma=0.5,brightness=1.5");
+    } catch (ErrException &e) {
+        cerr << "FAILED : unexpected exception: " << e.what() << endl;
+        failures++;
+    }
+
+    if (failures != 0) {
+        cerr << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "rgb_transform_test : passed" << endl;
+    return 0;
+}